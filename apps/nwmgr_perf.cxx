@@ -0,0 +1,313 @@
+/**
+ * @file nwmgr_perf.cxx Standalone NetworkManager load generator and sink
+ *
+ * Reads a nwmgr::Connections JSON file and runs one of the sender, receiver, publisher or
+ * subscriber roles, so that NetworkManager performance between two processes can be measured
+ * without a full DAQ partition.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Envelope.hpp"
+#include "networkmanager/LatencyHistogram.hpp"
+#include "networkmanager/NetworkManager.hpp"
+#include "networkmanager/nwmgr/Nljs.hpp"
+#include "networkmanager/nwmgr/Structs.hpp"
+
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+namespace po = boost::program_options;
+
+namespace {
+
+volatile std::sig_atomic_t g_stop_requested = 0;
+
+void
+signal_handler(int)
+{
+  g_stop_requested = 1;
+}
+
+/**
+ * @brief Header at the start of each nwmgr_perf message.
+ *
+ * The send time comes from the system clock so that latencies can be measured between hosts;
+ * they are only as accurate as the clock synchronization between them.
+ */
+struct PerfHeader
+{
+  uint64_t run_id = 0;
+  uint64_t sequence_number = 0;
+  int64_t send_time_ns = 0;
+};
+
+int64_t
+system_time_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+struct PerfConfig
+{
+  std::string role;
+  std::string connection;
+  std::string topic;
+  size_t message_size = 0;
+  double rate = 0.;
+  size_t burst = 0;
+  double duration = 0.;
+  double idle_timeout = 0.;
+  double report_interval = 0.;
+};
+
+void
+print_summary(std::string const& label, size_t messages, size_t bytes, double seconds)
+{
+  std::cout << std::fixed << std::setprecision(3) << label << ": " << messages << " messages, " << bytes
+            << " bytes in " << seconds << " s";
+  if (seconds > 0.) {
+    std::cout << " (" << messages / seconds << " msg/s, " << bytes / seconds / 1e6 << " MB/s)";
+  }
+  std::cout << std::endl;
+}
+
+void
+print_latency(LatencyHistogram::Summary const& summary)
+{
+  std::cout << std::fixed << std::setprecision(1) << "  latency [us]: mean " << summary.mean / 1000. << ", p50 "
+            << summary.p50 / 1000. << ", p90 " << summary.p90 / 1000. << ", p99 " << summary.p99 / 1000.
+            << ", p99.9 " << summary.p999 / 1000. << ", max " << summary.max / 1000. << std::endl;
+}
+
+int
+run_sender(PerfConfig const& conf)
+{
+  if (conf.role == "publisher") {
+    NetworkManager::get().start_publisher(conf.connection);
+  }
+
+  std::random_device rd;
+  PerfHeader header;
+  header.run_id = (static_cast<uint64_t>(rd()) << 32) | rd();
+
+  std::vector<char> buffer(std::max(conf.message_size, sizeof(PerfHeader)), 'x');
+  auto burst_period = conf.rate > 0. ? std::chrono::duration<double>(conf.burst / conf.rate)
+                                     : std::chrono::duration<double>(0.);
+
+  size_t sent = 0;
+  size_t timeouts = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(conf.duration));
+  auto next_burst = start;
+  auto next_report = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(conf.report_interval));
+
+  while (!g_stop_requested && (conf.duration <= 0. || std::chrono::steady_clock::now() < end)) {
+    for (size_t idx = 0; idx < conf.burst; ++idx) {
+      header.send_time_ns = system_time_ns();
+      memcpy(buffer.data(), &header, sizeof(header));
+      try {
+        NetworkManager::get().send_to(
+          conf.connection, buffer.data(), buffer.size(), std::chrono::milliseconds(1000), conf.topic);
+        ++sent;
+      } catch (ipm::SendTimeoutExpired const&) {
+        ++timeouts;
+      }
+      ++header.sequence_number;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (conf.report_interval > 0. && now >= next_report) {
+      print_summary("sent", sent, sent * buffer.size(), std::chrono::duration<double>(now - start).count());
+      next_report += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(conf.report_interval));
+    }
+
+    if (conf.rate > 0.) {
+      next_burst += std::chrono::duration_cast<std::chrono::steady_clock::duration>(burst_period);
+      std::this_thread::sleep_until(next_burst);
+    }
+  }
+
+  auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  print_summary("sent (total)", sent, sent * buffer.size(), seconds);
+  std::cout << "  send timeouts: " << timeouts << std::endl;
+  return 0;
+}
+
+int
+run_receiver(PerfConfig const& conf)
+{
+  // Subscribers receive by topic, receivers by connection name
+  auto source = conf.role == "subscriber" ? conf.topic : conf.connection;
+  NetworkManager::get().get_receiver(source);
+
+  SequenceTracker sequence_tracker;
+  LatencyHistogram interval_latency;
+  LatencyHistogram total_latency;
+  size_t received = 0;
+  size_t bytes = 0;
+  size_t missing = 0;
+  size_t out_of_order = 0;
+
+  std::chrono::steady_clock::time_point start;
+  auto last_message = std::chrono::steady_clock::now();
+  auto next_report = last_message;
+
+  while (!g_stop_requested) {
+    auto now = std::chrono::steady_clock::now();
+    if (received > 0 && conf.duration > 0. && std::chrono::duration<double>(now - start).count() >= conf.duration) {
+      break;
+    }
+    if (conf.idle_timeout > 0. && std::chrono::duration<double>(now - last_message).count() >= conf.idle_timeout) {
+      std::cout << "No message for " << conf.idle_timeout << " s, stopping" << std::endl;
+      break;
+    }
+
+    ipm::Receiver::Response response;
+    try {
+      response = NetworkManager::get().receive_from(source, std::chrono::milliseconds(100));
+    } catch (ipm::ReceiveTimeoutExpired const&) {
+      continue;
+    }
+
+    last_message = std::chrono::steady_clock::now();
+    if (received == 0) {
+      start = last_message;
+      next_report = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(conf.report_interval));
+    }
+    ++received;
+    bytes += response.data.size();
+
+    if (response.data.size() >= sizeof(PerfHeader)) {
+      PerfHeader header;
+      memcpy(&header, response.data.data(), sizeof(header));
+      auto latency_ns = system_time_ns() - header.send_time_ns;
+      interval_latency.record(latency_ns > 0 ? latency_ns : 0);
+      total_latency.record(latency_ns > 0 ? latency_ns : 0);
+
+      auto result = sequence_tracker.update(header.run_id, response.metadata, header.sequence_number);
+      missing += result.missing;
+      out_of_order += result.out_of_order ? 1 : 0;
+    }
+
+    if (conf.report_interval > 0. && last_message >= next_report) {
+      print_summary("received", received, bytes, std::chrono::duration<double>(last_message - start).count());
+      print_latency(interval_latency.collect_and_reset());
+      next_report += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(conf.report_interval));
+    }
+  }
+
+  auto seconds = received > 0 ? std::chrono::duration<double>(last_message - start).count() : 0.;
+  print_summary("received (total)", received, bytes, seconds);
+  std::cout << "  missing: " << missing << ", out of order: " << out_of_order;
+  if (received + missing > 0) {
+    std::cout << ", loss: " << std::setprecision(4) << 100. * missing / (received + missing) << " %";
+  }
+  std::cout << std::endl;
+  print_latency(total_latency.collect_and_reset());
+  return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  PerfConfig conf;
+  std::string config_file;
+
+  po::options_description desc("NetworkManager load generator and sink.\n"
+                               "Usage: nwmgr_perf -c connections.json -r <role> [options]");
+  desc.add_options()("help,h", "Print this help message")(
+    "config,c", po::value<std::string>(&config_file)->required(), "nwmgr::Connections JSON file")(
+    "role,r", po::value<std::string>(&conf.role)->required(), "One of sender, receiver, publisher, subscriber")(
+    "connection,n", po::value<std::string>(&conf.connection)->default_value(""), "Connection to send to or receive from")(
+    "topic,t", po::value<std::string>(&conf.topic)->default_value(""), "Topic to publish or subscribe to")(
+    "size,s", po::value<size_t>(&conf.message_size)->default_value(1024), "Message size in bytes")(
+    "rate", po::value<double>(&conf.rate)->default_value(0.), "Messages per second; 0 sends as fast as possible")(
+    "burst,b", po::value<size_t>(&conf.burst)->default_value(1), "Messages sent back-to-back in each burst")(
+    "duration,d",
+    po::value<double>(&conf.duration)->default_value(10.),
+    "Seconds to run for (receivers count from the first message); 0 runs until interrupted")(
+    "idle-timeout",
+    po::value<double>(&conf.idle_timeout)->default_value(5.),
+    "Receivers stop after this many seconds without a message; 0 disables")(
+    "report-interval", po::value<double>(&conf.report_interval)->default_value(1.), "Seconds between progress reports");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      std::cout << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (std::exception const& e) {
+    std::cerr << "Bad command line: " << e.what() << std::endl << desc << std::endl;
+    return 1;
+  }
+
+  bool is_sender = conf.role == "sender" || conf.role == "publisher";
+  bool is_receiver = conf.role == "receiver" || conf.role == "subscriber";
+  if (!is_sender && !is_receiver) {
+    std::cerr << "Unknown role " << conf.role << std::endl << desc << std::endl;
+    return 1;
+  }
+  if ((conf.role != "subscriber" && conf.connection.empty()) || (conf.role == "subscriber" && conf.topic.empty())) {
+    std::cerr << "Role " << conf.role << " needs a " << (conf.role == "subscriber" ? "topic" : "connection")
+              << std::endl;
+    return 1;
+  }
+  conf.burst = std::max<size_t>(conf.burst, 1);
+
+  nwmgr::Connections connections;
+  try {
+    std::ifstream config_stream(config_file);
+    nlohmann::json config_json = nlohmann::json::parse(config_stream);
+    connections = config_json.get<nwmgr::Connections>();
+  } catch (std::exception const& e) {
+    std::cerr << "Unable to read connections from " << config_file << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::signal(SIGINT, signal_handler);
+  std::signal(SIGTERM, signal_handler);
+
+  int result = 0;
+  try {
+    NetworkManager::get().configure(connections);
+    result = is_sender ? run_sender(conf) : run_receiver(conf);
+  } catch (ers::Issue const& issue) {
+    std::cerr << "nwmgr_perf failed: " << issue.what() << std::endl;
+    result = 2;
+  }
+  NetworkManager::get().reset();
+  return result;
+}
+
+#pragma GCC diagnostic pop
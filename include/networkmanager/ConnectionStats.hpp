@@ -0,0 +1,221 @@
+/**
+ *
+ * @file ConnectionStats.hpp NetworkManager per-connection statistics
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_CONNECTIONSTATS_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_CONNECTIONSTATS_HPP_
+
+#include "networkmanager/Envelope.hpp"
+#include "networkmanager/LatencyHistogram.hpp"
+#include "networkmanager/connectioninfo/InfoStructs.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace dunedaq {
+namespace networkmanager {
+
+constexpr size_t s_cache_line_size = 64;
+
+/**
+ * @brief Byte and message counters for one direction of a connection.
+ *
+ * Each direction lives on its own cache line so that sending and receiving threads do not
+ * invalidate each other's counters.
+ */
+struct alignas(s_cache_line_size) DirectionCounters
+{
+  std::atomic<uint64_t> bytes{ 0 };
+  std::atomic<uint64_t> messages{ 0 };
+
+  void add(size_t size)
+  {
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    messages.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * @brief Latency distributions recorded for a connection once detailed statistics are requested
+ */
+struct LatencyHistograms
+{
+  LatencyHistogram send_time;      ///< Total duration of send_to
+  LatencyHistogram lock_wait;      ///< Time send_to spends waiting for the connection lock
+  LatencyHistogram dispatch_delay; ///< Time between a Listener receiving a message and starting its callback
+  LatencyHistogram callback_time;  ///< Run time of the Listener callback
+};
+
+/**
+ * @brief State kept for connections (and topics) configured with envelope = true
+ */
+struct EnvelopeStats
+{
+  /// Next sequence number to send, per topic; guarded by the NetworkManager connection lock
+  std::unordered_map<std::string, uint64_t> next_sequence_numbers;
+
+  SequenceTracker sequence_tracker;
+  LatencyHistogram one_way_latency;
+  /// Lowered again when a message counted as missing arrives late
+  std::atomic<uint64_t> missing_messages{ 0 };
+  std::atomic<uint64_t> out_of_order_messages{ 0 };
+  std::atomic<uint64_t> invalid_envelopes{ 0 };
+
+  /// Chunked messages: chunks sent and received, and the receiving side's partly received messages
+  std::atomic<uint64_t> chunks_sent{ 0 };
+  std::atomic<uint64_t> chunks_received{ 0 };
+  Reassembler reassembler;
+};
+
+/**
+ * @brief What the Listener on a connection is doing, to find callbacks that stall it.
+ *
+ * Times are steady_clock nanoseconds since its epoch, with 0 meaning "never" or "not running".
+ */
+struct alignas(s_cache_line_size) ListenerActivity
+{
+  /// Overrun warnings are rate-limited, so that a consistently slow consumer does not flood the logs
+  static constexpr std::chrono::seconds s_overrun_warning_interval{ 10 };
+
+  /// Callbacks running longer than this count as overruns; zero disables the check. Set at configure.
+  std::chrono::steady_clock::duration callback_budget{ 0 };
+  /// How long each receive of the Listener waits; zero polls, sleeping between empty polls. Set at configure.
+  std::chrono::milliseconds poll_timeout{ 0 };
+  /// How long the Listener polls without waiting after each message; zero disables busy polling. Set at configure.
+  std::chrono::microseconds busy_poll{ 0 };
+
+  std::atomic<int64_t> last_receive_ns{ 0 };
+  std::atomic<int64_t> callback_start_ns{ 0 };
+  std::atomic<int64_t> reported_stall_ns{ 0 }; ///< callback_start_ns of the last stall reported by gather_stats
+  std::atomic<int64_t> last_overrun_warning_ns{ 0 };
+  std::atomic<uint64_t> callback_overruns{ 0 };
+  std::atomic<uint64_t> busy_poll_ns{ 0 };
+  std::atomic<uint64_t> busy_poll_hits{ 0 };
+  std::atomic<uint64_t> busy_poll_misses{ 0 };
+
+  /// Count an overrun, and warn about it, if a callback which just finished ran over the budget
+  void check_callback_duration(std::string const& name,
+                               std::chrono::steady_clock::duration duration,
+                               std::chrono::steady_clock::time_point now);
+
+  static int64_t to_ns(std::chrono::steady_clock::time_point time)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+  }
+};
+
+/**
+ * @brief Which address the sender of a connection uses, and how often it has had to reconnect
+ */
+struct SenderHealth
+{
+  std::atomic<bool> reconnecting{ false }; ///< A background reconnect is pending; sends fail until it succeeds
+  std::atomic<size_t> address_index{ 0 };  ///< Address in use, or to try first: 0 is the primary, then the alternates
+  std::atomic<uint64_t> failovers{ 0 };    ///< Times the sender switched to a different address
+  std::atomic<uint64_t> reconnects{ 0 };   ///< Successful background reconnects
+  /// Sends in a row which timed out; guarded by the NetworkManager connection lock
+  size_t consecutive_timeouts{ 0 };
+};
+
+/**
+ * @brief Counters owned by NetworkManager for a single connection or topic.
+ *
+ * The data path only performs relaxed atomic increments; gather_stats reads the counters
+ * without taking any lock that the data path uses.
+ */
+class ConnectionStats
+{
+public:
+  /// Connections are reported at least this often by gather_stats, even when they have not changed
+  static constexpr std::chrono::seconds s_idle_report_interval{ 60 };
+
+  ConnectionStats();
+
+  ConnectionStats(ConnectionStats const&) = delete;
+  ConnectionStats(ConnectionStats&&) = delete;
+  ConnectionStats& operator=(ConnectionStats const&) = delete;
+  ConnectionStats& operator=(ConnectionStats&&) = delete;
+
+  void record_send(size_t size) { m_sent.add(size); }
+  void record_receive(size_t size) { m_received.add(size); }
+
+  /**
+   * @brief Histograms to record into, or nullptr if they have not been enabled.
+   *
+   * The data path checks this before taking any timestamps, so latency measurement costs a
+   * single load until someone asks for it.
+   */
+  LatencyHistograms* latency() const { return m_latency.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Allocate the latency histograms if needed and return them.
+   *
+   * Samples recorded before an earlier disable_latency_histograms are discarded. Must be serialized
+   * with other calls to enable_latency_histograms, disable_latency_histograms and fill_info.
+   */
+  LatencyHistograms& enable_latency_histograms();
+  /// Stop recording latencies; the histograms are kept, since the data path may still be recording into them
+  void disable_latency_histograms() { m_latency.store(nullptr, std::memory_order_release); }
+
+  ListenerActivity& listener_activity() { return m_listener_activity; }
+  SenderHealth& sender_health() { return m_sender_health; }
+
+  /// Envelope state, or nullptr if the connection does not use envelopes
+  EnvelopeStats* envelope() const { return m_envelope.get(); }
+
+  /// Must be called before any traffic on the connection
+  void enable_envelope() { m_envelope = std::make_unique<EnvelopeStats>(); }
+
+  /**
+   * @brief Fill info with the current counters and the rates since the previous call.
+   *
+   * Not thread-safe with respect to other callers of fill_info; NetworkManager serializes
+   * calls from gather_stats.
+   */
+  void fill_info(connectioninfo::Info& info);
+
+  /// Add the counters (but not the rates or gauges) to those in totals
+  void add_to_totals(connectioninfo::Info& totals) const;
+
+  /// Set the rate fields of info from its counters and those of a report made the given number of seconds earlier
+  static void fill_rates(connectioninfo::Info& info, connectioninfo::Info const& last_info, double seconds);
+
+  /**
+   * @brief Whether fill_info has anything new to report.
+   *
+   * That is the case when a counter has changed since its previous call, a callback is running,
+   * the previous call reported non-zero rates, or s_idle_report_interval has passed since then.
+   * Must be serialized with fill_info.
+   */
+  bool changed_since_last_info(std::chrono::steady_clock::time_point now) const;
+
+private:
+  void fill_counters(connectioninfo::Info& info) const;
+
+  DirectionCounters m_sent;
+  DirectionCounters m_received;
+  ListenerActivity m_listener_activity;
+  SenderHealth m_sender_health;
+
+  std::unique_ptr<EnvelopeStats> m_envelope{ nullptr };
+  std::unique_ptr<LatencyHistograms> m_latency_storage{ nullptr };
+  std::atomic<LatencyHistograms*> m_latency{ nullptr };
+
+  connectioninfo::Info m_last_info;
+  std::chrono::steady_clock::time_point m_last_time;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_CONNECTIONSTATS_HPP_
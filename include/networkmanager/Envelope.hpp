@@ -0,0 +1,180 @@
+/**
+ *
+ * @file Envelope.hpp Message envelope used for end-to-end latency and loss tracing
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_ENVELOPE_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_ENVELOPE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Header prepended to each message on connections configured with envelope = true.
+ *
+ * The send timestamp is taken from std::chrono::steady_clock, so one-way latencies are only
+ * meaningful when sender and receiver share the same monotonic clock (i.e. run on the same host).
+ */
+struct EnvelopeHeader
+{
+  static constexpr uint32_t s_magic = 0x454d574e; // "NWME"
+  static constexpr uint16_t s_version = 1;
+  static constexpr size_t s_size = 32;
+  /// The envelope is followed by a ChunkHeader and one chunk of a larger message
+  static constexpr uint16_t s_flag_chunk = 0x1;
+
+  uint32_t magic = s_magic;
+  uint16_t version = s_version;
+  uint16_t flags = 0;
+  uint64_t sequence_number = 0;
+  uint64_t send_time_ns = 0;
+  uint64_t sender_id = 0;
+
+  /// Write the header in its wire format; destination must have room for s_size bytes
+  void write(char* destination) const;
+
+  /// Read a header from the start of data, returning false if data does not start with a valid header
+  bool read(const char* data, size_t size);
+};
+
+/**
+ * @brief Tracks sequence numbers per (sender, stream) to detect lost and reordered messages.
+ *
+ * A stream is a connection/topic pair, since senders number messages independently per topic.
+ * The first message seen from a stream only establishes its starting point. Skipped sequence
+ * numbers are counted as missing and remembered as gaps, so that a message arriving late, into a
+ * gap, is reported as recovered rather than staying counted as lost. At most s_max_gaps gaps are
+ * remembered per stream; beyond that, the oldest are given up.
+ */
+class SequenceTracker
+{
+public:
+  static constexpr size_t s_max_gaps = 1024;
+
+  struct Result
+  {
+    uint64_t missing = 0;      ///< Sequence numbers skipped before this message
+    bool out_of_order = false; ///< Message was older than, or a duplicate of, one already seen
+    bool recovered = false;    ///< Message was late, and had been counted as missing
+  };
+
+  Result update(uint64_t sender_id, std::string const& stream, uint64_t sequence_number);
+
+private:
+  struct Stream
+  {
+    uint64_t last_sequence_number = 0;
+    /// Sequence numbers not received yet, as ranges from first to last, by first
+    std::map<uint64_t, uint64_t> gaps;
+  };
+
+  void add_gap(Stream& stream, uint64_t first, uint64_t last);
+
+  std::map<std::pair<uint64_t, std::string>, Stream> m_streams;
+  std::mutex m_mutex;
+};
+
+/**
+ * @brief Position of a chunk within a message, following the envelope of each chunk.
+ *
+ * All chunks of a message carry the message's envelope sequence number, which together with the
+ * sender ID and topic identifies the message they belong to.
+ */
+struct ChunkHeader
+{
+  static constexpr size_t s_size = 16;
+
+  uint64_t message_size = 0; ///< Size of the whole message
+  uint64_t offset = 0;       ///< Position of this chunk's data in the message
+
+  /// Write the header in its wire format; destination must have room for s_size bytes
+  void write(char* destination) const;
+
+  /// Read a header from the start of data, returning false if data is too short to hold one
+  bool read(const char* data, size_t size);
+};
+
+/**
+ * @brief Puts chunked messages back together.
+ *
+ * The first chunk of a message to arrive allocates a buffer for the whole message, into which every
+ * chunk is copied at its offset, so chunks may arrive in any order and interleaved with those of
+ * other messages. A message is complete once its chunks cover all of it; repeated chunks are ignored,
+ * and chunks overlapping others are invalid. Messages which receive no chunk for s_timeout are
+ * abandoned. Chunks announcing a message larger than the maximum message size, which is 0 until set,
+ * are invalid, so that a corrupt header cannot make the receiver allocate an arbitrary amount of memory.
+ */
+class Reassembler
+{
+public:
+  static constexpr std::chrono::seconds s_timeout{ 10 };
+  /// Most chunks a message may be split into; with the chunk size, this gives the maximum message size
+  static constexpr uint64_t s_max_chunks = 4096;
+
+  enum class Status
+  {
+    Incomplete, ///< More chunks of the message are expected (or the chunk had already been received)
+    Complete,   ///< The chunk completed the message
+    Invalid     ///< The chunk does not fit in the message, and was dropped
+  };
+
+  struct Result
+  {
+    Status status = Status::Incomplete;
+    bool first_chunk = false; ///< The chunk was the first to arrive of its message
+  };
+
+  /// Add a chunk to its message; when it completes the message, the message's data is moved into data
+  Result add(uint64_t sender_id,
+             std::string const& stream,
+             uint64_t sequence_number,
+             ChunkHeader const& chunk,
+             const char* chunk_data,
+             size_t chunk_size,
+             std::vector<char>& data,
+             std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+  /// Largest message accepted; set by NetworkManager::configure from the connection's chunk size
+  void set_max_message_size(uint64_t size) { m_max_message_size.store(size, std::memory_order_relaxed); }
+  uint64_t max_message_size() const { return m_max_message_size.load(std::memory_order_relaxed); }
+
+  size_t pending() const;
+  uint64_t abandoned_messages() const { return m_abandoned_messages.load(std::memory_order_relaxed); }
+
+private:
+  struct Message
+  {
+    std::vector<char> data;
+    /// Size of each chunk received, by offset
+    std::map<uint64_t, uint64_t> chunks;
+    uint64_t received_bytes = 0;
+    std::chrono::steady_clock::time_point last_chunk_time;
+  };
+
+  void abandon_stale_messages(std::chrono::steady_clock::time_point now);
+
+  std::map<std::tuple<uint64_t, std::string, uint64_t>, Message> m_messages;
+  mutable std::mutex m_mutex;
+  std::atomic<uint64_t> m_abandoned_messages{ 0 };
+  std::atomic<uint64_t> m_max_message_size{ 0 };
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_ENVELOPE_HPP_
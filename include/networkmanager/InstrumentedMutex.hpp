@@ -0,0 +1,73 @@
+/**
+ *
+ * @file InstrumentedMutex.hpp Mutex recording its own contention statistics
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_INSTRUMENTEDMUTEX_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_INSTRUMENTEDMUTEX_HPP_
+
+#include "networkmanager/connectioninfo/InfoStructs.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Drop-in replacement for std::mutex which can record acquisitions, wait and hold times.
+ *
+ * Recording is off by default for all instances, and then costs one relaxed atomic load per
+ * lock(). Once enabled with set_enabled(true), each acquisition reads the clock when it is
+ * taken and released, and the time spent waiting is only measured when try_lock() fails.
+ */
+class InstrumentedMutex
+{
+public:
+  InstrumentedMutex() = default;
+
+  InstrumentedMutex(InstrumentedMutex const&) = delete;
+  InstrumentedMutex(InstrumentedMutex&&) = delete;
+  InstrumentedMutex& operator=(InstrumentedMutex const&) = delete;
+  InstrumentedMutex& operator=(InstrumentedMutex&&) = delete;
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+  /**
+   * @brief Fill a LockInfo record from the interval since the previous call, and start a new interval
+   */
+  void fill_info(connectioninfo::LockInfo& info);
+
+  static void set_enabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+  static bool is_enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+private:
+  using clock_type = std::chrono::steady_clock;
+
+  void record_acquisition(clock_type::time_point locked_at, uint64_t wait_ns);
+
+  std::mutex m_mutex;
+  clock_type::time_point m_locked_at{}; // Guarded by m_mutex; zero when the hold is not timed
+
+  std::atomic<uint64_t> m_acquisitions{ 0 };
+  std::atomic<uint64_t> m_contended_acquisitions{ 0 };
+  std::atomic<uint64_t> m_wait_ns{ 0 };
+  std::atomic<uint64_t> m_max_wait_ns{ 0 };
+  std::atomic<uint64_t> m_hold_ns{ 0 };
+  std::atomic<uint64_t> m_max_hold_ns{ 0 };
+
+  static std::atomic<bool> s_enabled;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_INSTRUMENTEDMUTEX_HPP_
@@ -25,6 +25,81 @@ ERS_DECLARE_ISSUE(networkmanager,
                   "Topic named " << name << " not found for connection " << connection,
                   ((std::string)name)((std::string)connection))
 ERS_DECLARE_ISSUE(networkmanager, NameCollision, "Multiple instances of name " << name << " exist", ((std::string)name))
+ERS_DECLARE_ISSUE(networkmanager,
+                  InvalidAddress,
+                  "Address " << address << " is not valid: " << reason,
+                  ((std::string)address)((std::string)reason))
+ERS_DECLARE_ISSUE(networkmanager,
+                  EnvelopeMismatch,
+                  "Connections declaring topic " << name << " do not agree on envelope mode",
+                  ((std::string)name))
+ERS_DECLARE_ISSUE(networkmanager,
+                  EnvelopeRequired,
+                  "Connection named " << name << " needs envelope = true for " << feature,
+                  ((std::string)name)((std::string)feature))
+ERS_DECLARE_ISSUE(networkmanager,
+                  MessageTooLarge,
+                  "Message of " << size << " bytes is larger than the " << max_size << " bytes connection " << name
+                                << " can send in chunks",
+                  ((std::string)name)((size_t)size)((size_t)max_size))
+ERS_DECLARE_ISSUE(networkmanager,
+                  InvalidStriping,
+                  "Striping of connection " << name << " is not valid: " << reason,
+                  ((std::string)name)((std::string)reason))
+ERS_DECLARE_ISSUE(networkmanager,
+                  InvalidEnvelope,
+                  "Message of " << size << " bytes received on " << name << " does not start with a valid envelope",
+                  ((std::string)name)((size_t)size))
+ERS_DECLARE_ISSUE(networkmanager,
+                  ArenaCreationFailed,
+                  "Unable to map a message arena of " << size << " bytes: " << reason,
+                  ((size_t)size)((std::string)reason))
+ERS_DECLARE_ISSUE(networkmanager,
+                  CallbackOverrun,
+                  "Listener callback for " << name << " has run for " << duration_ms << " ms, over its budget of "
+                                           << budget_ms << " ms (" << overruns << " overruns in total)",
+                  ((std::string)name)((double)duration_ms)((double)budget_ms)((uint64_t)overruns))
+ERS_DECLARE_ISSUE(networkmanager,
+                  CallbackFailed,
+                  "Listener callback for " << name << " failed: " << reason,
+                  ((std::string)name)((std::string)reason))
+ERS_DECLARE_ISSUE(networkmanager,
+                  KeyExtractionFailed,
+                  "Unable to find the key of a message received on " << name << ", which is dropped: " << reason,
+                  ((std::string)name)((std::string)reason))
+ERS_DECLARE_ISSUE(networkmanager,
+                  ConnectionUnavailable,
+                  "Connection named " << name << " is being reconnected, message not sent",
+                  ((std::string)name))
+ERS_DECLARE_ISSUE(networkmanager,
+                  NoReplyConnection,
+                  "Connection named " << name << " has no reply connection configured",
+                  ((std::string)name))
+ERS_DECLARE_ISSUE(networkmanager,
+                  RequestTimedOut,
+                  "No reply to request " << correlation_id << " on " << name << " within " << timeout_ms << " ms",
+                  ((std::string)name)((uint64_t)correlation_id)((int64_t)timeout_ms))
+ERS_DECLARE_ISSUE(networkmanager,
+                  RequestCancelled,
+                  "Request " << correlation_id << " on " << name << " was cancelled before it received a reply",
+                  ((std::string)name)((uint64_t)correlation_id))
+ERS_DECLARE_ISSUE(networkmanager,
+                  InvalidRequestMessage,
+                  "Message of " << size << " bytes received on " << name << " is not a valid request or reply",
+                  ((std::string)name)((size_t)size))
+ERS_DECLARE_ISSUE(networkmanager,
+                  ReplyFailed,
+                  "Unable to reply to request " << correlation_id << " received on " << name << ": " << reason,
+                  ((std::string)name)((uint64_t)correlation_id)((std::string)reason))
+ERS_DECLARE_ISSUE(networkmanager,
+                  DrainTimedOut,
+                  "Stopping the Listener on " << name << " drained " << drained << " messages within " << timeout_ms
+                                              << " ms, and left the rest queued",
+                  ((std::string)name)((size_t)drained)((int64_t)timeout_ms))
+ERS_DECLARE_ISSUE(networkmanager,
+                  TeardownIncomplete,
+                  "Teardown did not finish within " << timeout_ms << " ms, still waiting for " << remaining,
+                  ((int64_t)timeout_ms)((std::string)remaining))
 
 ERS_DECLARE_ISSUE(networkmanager,
                   ConnectionAlreadyOpen,
@@ -0,0 +1,106 @@
+/**
+ *
+ * @file KeyedDispatcher.hpp Parallel callback dispatch preserving the order of messages with the same key
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_KEYEDDISPATCHER_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_KEYEDDISPATCHER_HPP_
+
+#include "networkmanager/ConnectionStats.hpp"
+
+#include "ipm/Receiver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Runs a Listener's callback on several worker threads.
+ *
+ * Each message goes to the worker chosen by a hash of its key, so messages with the same key
+ * are processed one at a time and in the order they were received, while messages with
+ * different keys may be processed in parallel. Worker queues are bounded: when a worker falls
+ * s_queue_capacity messages behind, dispatch() blocks, and with it the Listener.
+ *
+ * A callback which throws is reported, and the worker goes on with its next message; a message for
+ * which the key extractor throws is reported and dropped. While callbacks are running, the start of
+ * the oldest is what the Listener's stats report as its time in callback.
+ */
+class KeyedDispatcher
+{
+public:
+  using callback_t = std::function<void(ipm::Receiver::Response)>;
+  using key_extractor_t = std::function<uint64_t(ipm::Receiver::Response const&)>;
+
+  static constexpr size_t s_queue_capacity = 1000;
+
+  /// stats may be nullptr; otherwise callback times and overruns are recorded in it under the given name
+  KeyedDispatcher(callback_t callback,
+                  key_extractor_t key_extractor,
+                  size_t worker_count,
+                  std::string const& name,
+                  ConnectionStats* stats);
+  /// Processes the messages already queued, then stops the workers
+  ~KeyedDispatcher();
+
+  KeyedDispatcher(KeyedDispatcher const&) = delete;
+  KeyedDispatcher(KeyedDispatcher&&) = delete;
+  KeyedDispatcher& operator=(KeyedDispatcher const&) = delete;
+  KeyedDispatcher& operator=(KeyedDispatcher&&) = delete;
+
+  void dispatch(ipm::Receiver::Response&& response, std::chrono::steady_clock::time_point received_time);
+
+  size_t worker_count() const { return m_workers.size(); }
+  size_t worker_for(uint64_t key) const;
+
+private:
+  struct Item
+  {
+    ipm::Receiver::Response response;
+    std::chrono::steady_clock::time_point received_time;
+  };
+
+  struct Worker
+  {
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<Item> queue;
+    bool stop{ false };
+    std::atomic<int64_t> callback_start_ns{ 0 };
+    std::thread thread;
+  };
+
+  void worker_loop(Worker& worker);
+  void run_callback(Worker& worker, Item&& item);
+  /// Sets the worker's callback start, zero once it has finished, and publishes the oldest one to the stats
+  void set_callback_start(Worker& worker, int64_t start_ns);
+
+  callback_t m_callback;
+  key_extractor_t m_key_extractor;
+  std::string m_name;
+  ConnectionStats* m_stats;
+  std::mutex m_callback_start_mutex;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_KEYEDDISPATCHER_HPP_
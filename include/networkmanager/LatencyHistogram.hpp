@@ -0,0 +1,91 @@
+/**
+ *
+ * @file LatencyHistogram.hpp Log-linear latency histogram used by NetworkManager statistics
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_LATENCYHISTOGRAM_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_LATENCYHISTOGRAM_HPP_
+
+#include "networkmanager/connectioninfo/InfoStructs.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief HDR-style histogram of durations in nanoseconds.
+ *
+ * Each power of two is split into s_sub_bucket_count linear buckets, giving a relative
+ * precision of 1/s_sub_bucket_count over the whole range. Recording is a single relaxed
+ * atomic increment (plus the running sum); values above the range go to the last bucket.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr unsigned s_sub_bucket_bits = 3;
+  static constexpr uint64_t s_sub_bucket_count = 1ULL << s_sub_bucket_bits;
+  static constexpr unsigned s_max_exponent = 36; // ~137 s in nanoseconds
+  static constexpr size_t s_bucket_count = (s_max_exponent - 1) * s_sub_bucket_count;
+
+  struct Summary
+  {
+    uint64_t count = 0;
+    double mean = 0.;
+    double p50 = 0.;
+    double p90 = 0.;
+    double p99 = 0.;
+    double p999 = 0.;
+    double max = 0.;
+  };
+
+  LatencyHistogram() = default;
+
+  LatencyHistogram(LatencyHistogram const&) = delete;
+  LatencyHistogram(LatencyHistogram&&) = delete;
+  LatencyHistogram& operator=(LatencyHistogram const&) = delete;
+  LatencyHistogram& operator=(LatencyHistogram&&) = delete;
+
+  void record(uint64_t value_ns)
+  {
+    m_buckets[bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value_ns, std::memory_order_relaxed);
+  }
+  void record(std::chrono::steady_clock::duration duration)
+  {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+  }
+
+  /**
+   * @brief Compute the summary of the values recorded since the previous call, and start a new interval.
+   *
+   * Percentiles are reported as the upper edge of the bucket containing them, in nanoseconds.
+   */
+  Summary collect_and_reset();
+
+  /**
+   * @brief Fill a LatencyInfo record (in microseconds) from the interval since the previous call
+   */
+  void fill_info(connectioninfo::LatencyInfo& info);
+
+  static size_t bucket_index(uint64_t value);
+  static uint64_t bucket_upper_edge(size_t index);
+
+private:
+  std::array<std::atomic<uint64_t>, s_bucket_count> m_buckets{};
+  std::atomic<uint64_t> m_sum{ 0 };
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_LATENCYHISTOGRAM_HPP_
@@ -10,15 +10,19 @@
 #ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_LISTENER_HPP_
 #define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_LISTENER_HPP_
 
+#include "networkmanager/InstrumentedMutex.hpp"
 #include "networkmanager/Issues.hpp"
+#include "networkmanager/KeyedDispatcher.hpp"
 
 #include "ipm/Receiver.hpp"
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -27,10 +31,23 @@
 namespace dunedaq {
 namespace networkmanager {
 
+class ConnectionStats;
+class NetworkManager;
+
 class Listener
 {
 public:
-  Listener() = default; // Excplicitly defaulted
+  /// How long a Listener which polls without waiting sleeps when nothing has arrived
+  static constexpr std::chrono::milliseconds s_idle_wait{ 10 };
+  /// Messages delivered to the callback while draining, and whether the deadline passed before the socket was empty
+  struct DrainResult
+  {
+    size_t drained = 0;
+    bool timed_out = false; ///< Messages may still be queued in the socket
+  };
+
+  Listener() = default; // Excplicitly defaulted, receives through NetworkManager::get()
+  explicit Listener(NetworkManager* manager);
 
   virtual ~Listener() noexcept;
   Listener(Listener&&);
@@ -41,20 +58,58 @@ public:
 
   void start_listening(std::string const& connection_name);
   void stop_listening();
+  /**
+   * @brief Stop listening once the messages already queued in the socket have been delivered.
+   *
+   * After the stop request, messages go on being received, without waiting, and delivered to the
+   * callback until the socket is empty or drain_timeout has passed. Messages still queued at the
+   * deadline are left in the socket, and reported through DrainResult::timed_out.
+   */
+  DrainResult stop_listening(std::chrono::milliseconds drain_timeout);
+  /// request_stop() followed by join()
   void shutdown();
+  /// Tell the thread to stop after its current receive and callback, without waiting for it
+  void request_stop() noexcept;
+  /// Wait until deadline for the thread to stop; returns false, leaving it to a later join(), if it is still running
+  bool wait_stopped(std::chrono::steady_clock::time_point deadline);
+  /// Wait for the thread to stop, and drop the callback
+  void join();
   void set_callback(std::function<void(ipm::Receiver::Response)> callback);
+  /// Run the callback on worker_count threads, keeping messages with the same key in order
+  void set_callback(std::function<void(ipm::Receiver::Response)> callback,
+                    KeyedDispatcher::key_extractor_t key_extractor,
+                    size_t worker_count);
 
   bool is_listening() const { return m_is_listening.load(); }
+  void fill_lock_info(connectioninfo::LockInfo& info) { m_callback_mutex.fill_info(info); }
 
 private:
   void startup();
   void listener_thread_loop();
+  void dispatch(ipm::Receiver::Response&& response,
+                std::chrono::steady_clock::time_point received_time,
+                ConnectionStats* stats);
+  // Called on the Listener thread after it has been told to stop, if it is to drain the socket
+  void drain(NetworkManager& manager, ConnectionStats* stats);
+
+  NetworkManager& manager() const;
 
+  NetworkManager* m_manager{ nullptr };
   std::string m_connection_name = "";
   std::function<void(ipm::Receiver::Response)> m_callback;
-  mutable std::mutex m_callback_mutex;
+  std::unique_ptr<KeyedDispatcher> m_dispatcher{ nullptr };
+  mutable InstrumentedMutex m_callback_mutex;
   std::unique_ptr<std::thread> m_listener_thread{ nullptr };
   std::atomic<bool> m_is_listening{ false };
+
+  // Wake the thread from its idle wait when it is told to stop, and tell waiters when it has stopped
+  std::mutex m_stop_mutex;
+  std::condition_variable m_stop_cv;
+  bool m_thread_running{ false };
+
+  // Set by stop_listening(drain_timeout) before the stop request, and read by the thread after it
+  std::optional<std::chrono::steady_clock::time_point> m_drain_deadline;
+  DrainResult m_drain_result;
 };
 } // namespace networkmanager
 } // namespace dunedaq
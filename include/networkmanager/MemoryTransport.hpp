@@ -0,0 +1,113 @@
+/**
+ *
+ * @file MemoryTransport.hpp In-process loopback implementation of the IPM interfaces
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_MEMORYTRANSPORT_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_MEMORYTRANSPORT_HPP_
+
+#include "ipm/Receiver.hpp"
+#include "ipm/Sender.hpp"
+#include "ipm/Subscriber.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Link parameters of a mem:// channel, given as query parameters of its address.
+ *
+ * For example mem://my_channel?latency_us=50&bandwidth_mbps=10000&drop_rate=0.001&seed=1.
+ * The first endpoint to open a channel sets its parameters.
+ */
+struct MemoryLinkParameters
+{
+  std::chrono::microseconds latency{ 0 }; ///< Added to the delivery time of every message
+  double bandwidth_mbps = 0.;             ///< Link speed in megabits per second; 0 is unlimited
+  double drop_rate = 0.;                  ///< Fraction of messages silently dropped
+  uint64_t seed = 0;                      ///< Seed of the drop decisions, which are deterministic
+  size_t capacity = 10000;                ///< Messages queued per receiver before sends block
+
+  static MemoryLinkParameters parse(std::string const& address, std::string& channel_name);
+};
+
+class MemoryChannel;
+class MemoryQueue;
+
+/// Whether an address selects the in-process loopback transport
+bool
+is_memory_address(std::string const& address);
+
+/**
+ * @brief Sender (or publisher) on a mem:// channel.
+ *
+ * Messages are copied into the queue of the receiving side with a delivery time computed from
+ * the channel's latency and bandwidth, so results are reproducible and free of socket overhead.
+ */
+class MemorySender : public ipm::Sender
+{
+public:
+  explicit MemorySender(bool publisher);
+
+  void connect_for_sends(const nlohmann::json& connection_info) override;
+  bool can_send() const noexcept override { return m_channel != nullptr; }
+
+protected:
+  void send_(const void* message, message_size_t N, const duration_t& timeout, std::string const& metadata) override;
+
+private:
+  bool m_publisher;
+  std::shared_ptr<MemoryChannel> m_channel{ nullptr };
+};
+
+/**
+ * @brief Receiver on a point-to-point mem:// channel
+ */
+class MemoryReceiver : public ipm::Receiver
+{
+public:
+  void connect_for_receives(const nlohmann::json& connection_info) override;
+  bool can_receive() const noexcept override { return m_channel != nullptr; }
+
+protected:
+  Response receive_(const duration_t& timeout) override;
+
+private:
+  std::shared_ptr<MemoryChannel> m_channel{ nullptr };
+};
+
+/**
+ * @brief Subscriber to one or more mem:// publishers, with ZMQ-style topic prefix matching
+ */
+class MemorySubscriber : public ipm::Subscriber
+{
+public:
+  void connect_for_receives(const nlohmann::json& connection_info) override;
+  bool can_receive() const noexcept override { return !m_channels.empty(); }
+
+  void subscribe(std::string const& topic) override;
+  void unsubscribe(std::string const& topic) override;
+
+protected:
+  Response receive_(const duration_t& timeout) override;
+
+private:
+  std::shared_ptr<MemoryQueue> m_queue{ nullptr };
+  std::vector<std::shared_ptr<MemoryChannel>> m_channels;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_MEMORYTRANSPORT_HPP_
@@ -0,0 +1,120 @@
+/**
+ *
+ * @file MessageArena.hpp Pre-faulted, hugepage-backed memory for large message buffers
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_MESSAGEARENA_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_MESSAGEARENA_HPP_
+
+#include "networkmanager/connectioninfo/InfoStructs.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+class MessageArena;
+
+/**
+ * @brief A message buffer, carved from a MessageArena or from the heap, returned when destroyed
+ */
+class ArenaBuffer
+{
+public:
+  ArenaBuffer() = default;
+  explicit ArenaBuffer(size_t size); ///< Heap-allocated buffer, for when there is no arena
+  ~ArenaBuffer();
+
+  ArenaBuffer(ArenaBuffer&& other) noexcept;
+  ArenaBuffer& operator=(ArenaBuffer&& other) noexcept;
+
+  ArenaBuffer(ArenaBuffer const&) = delete;
+  ArenaBuffer& operator=(ArenaBuffer const&) = delete;
+
+  char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool from_arena() const { return m_arena != nullptr; }
+
+private:
+  friend class MessageArena;
+  ArenaBuffer(std::shared_ptr<MessageArena> arena, char* data, size_t size, size_t size_class);
+
+  void release();
+
+  std::shared_ptr<MessageArena> m_arena{ nullptr };
+  std::unique_ptr<char[]> m_heap_data{ nullptr };
+  char* m_data{ nullptr };
+  size_t m_size{ 0 };
+  size_t m_size_class{ 0 };
+};
+
+/**
+ * @brief A fixed region of memory, mapped once, from which message buffers are allocated.
+ *
+ * The region is backed by explicit hugepages (MAP_HUGETLB) when the system has them reserved,
+ * and otherwise asks for transparent hugepages; it can be pre-faulted so that first use of a
+ * buffer does not page fault. Buffers are rounded up to power-of-two size classes and carved out
+ * by a buddy allocator: a free block twice the size is split in halves when a class has no free
+ * block, and a released block is merged back with its buddy when that is free too, so memory freed
+ * by one size class is available to the others. Requests that do not fit in any free block are
+ * served from the heap and counted as fallbacks.
+ */
+class MessageArena : public std::enable_shared_from_this<MessageArena>
+{
+public:
+  static constexpr size_t s_min_block_size = 4096;
+  static constexpr size_t s_huge_page_size = 2 * 1024 * 1024;
+
+  static std::shared_ptr<MessageArena> create(size_t size, bool huge_pages, bool prefault);
+  ~MessageArena();
+
+  MessageArena(MessageArena const&) = delete;
+  MessageArena(MessageArena&&) = delete;
+  MessageArena& operator=(MessageArena const&) = delete;
+  MessageArena& operator=(MessageArena&&) = delete;
+
+  ArenaBuffer allocate(size_t size);
+
+  size_t capacity() const { return m_capacity; }
+  bool uses_explicit_huge_pages() const { return m_explicit_huge_pages; }
+
+  void fill_info(connectioninfo::ArenaInfo& info) const;
+
+  /// Index of the size class holding buffers of the given size
+  static size_t size_class(size_t size);
+
+private:
+  friend class ArenaBuffer;
+  MessageArena(char* region, size_t capacity, bool explicit_huge_pages);
+
+  void release(char* data, size_t size_class);
+  // Size class of the largest block, aligned to its size within the region, of which the block at offset is part
+  size_t max_size_class(size_t offset) const;
+
+  char* m_region;
+  size_t m_capacity;
+  bool m_explicit_huge_pages;
+
+  std::mutex m_mutex;
+  std::vector<std::set<char*>> m_free; // Free blocks of each size class, by address; guarded by m_mutex
+
+  std::atomic<uint64_t> m_used_bytes{ 0 };
+  std::atomic<uint64_t> m_peak_used_bytes{ 0 };
+  std::atomic<uint64_t> m_allocations{ 0 };
+  std::atomic<uint64_t> m_fallback_allocations{ 0 };
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_MESSAGEARENA_HPP_
@@ -10,8 +10,15 @@
 #ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_NETWORKMANAGER_HPP_
 #define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_NETWORKMANAGER_HPP_
 
+#include "networkmanager/ConnectionStats.hpp"
+#include "networkmanager/InstrumentedMutex.hpp"
 #include "networkmanager/Issues.hpp"
 #include "networkmanager/Listener.hpp"
+#include "networkmanager/MessageArena.hpp"
+#include "networkmanager/Reconnector.hpp"
+#include "networkmanager/RequestReply.hpp"
+#include "networkmanager/TopicTrie.hpp"
+#include "networkmanager/WorkerPool.hpp"
 #include "networkmanager/nwmgr/Structs.hpp"
 
 #include "ipm/Receiver.hpp"
@@ -19,20 +26,33 @@
 #include "ipm/Subscriber.hpp"
 #include "opmonlib/InfoCollector.hpp"
 
+#include <nlohmann/json.hpp>
+
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace dunedaq {
 
 namespace networkmanager {
+
+/**
+ * @brief Owns the connection table, IPM plugins and Listener threads of one set of connections.
+ *
+ * get() returns the process-wide default instance. Further instances may be constructed
+ * independently, e.g. one per subsystem, and share no maps, locks or threads with each other.
+ */
 class NetworkManager
 {
 
@@ -43,19 +63,96 @@ public:
     Recv
   };
 
+  /// gather_stats level from which each connection and topic is reported, rather than only their totals
+  static constexpr int s_connection_stats_level = 1;
+  /// gather_stats level from which latency histograms are recorded and reported
+  static constexpr int s_latency_stats_level = 2;
+  /// gather_stats level from which the internal locks record and report contention statistics
+  static constexpr int s_lock_stats_level = 3;
+  /// Name of the gather_stats entry holding the statistics of the locks not tied to a connection
+  static constexpr const char* s_lock_stats_name = "networkmanager_locks";
+  /// Name of the gather_stats entry holding the sum of the counters of all connections and topics
+  static constexpr const char* s_totals_stats_name = "networkmanager_totals";
+  /// Name of the gather_stats entry holding the occupancy of the message arena
+  static constexpr const char* s_arena_stats_name = "networkmanager_arena";
+  /// Timeout for sending a reply from a request handler
+  static constexpr ipm::Sender::duration_t s_reply_timeout{ 1000 };
+  /// How long reset() waits for all Listeners to stop and all plugins to close
+  static constexpr std::chrono::milliseconds s_teardown_timeout{ 1000 };
+  /// Threads on which reset() closes plugins in parallel
+  static constexpr size_t s_teardown_threads = 8;
+  /// Sends in a row which must time out before a connection with alternate addresses fails over
+  static constexpr size_t s_failover_timeouts = 3;
+  /// Threads, shared by all publish() calls, sending to the connections of a topic beyond the first
+  static constexpr size_t s_publish_threads = 16;
+
+  /// Computes the payload of the reply to a request
+  using request_handler_t = std::function<std::vector<char>(ipm::Receiver::Response)>;
+
+  NetworkManager() = default;
+  ~NetworkManager();
+
+  NetworkManager(NetworkManager const&) = delete;
+  NetworkManager(NetworkManager&&) = delete;
+  NetworkManager& operator=(NetworkManager const&) = delete;
+  NetworkManager& operator=(NetworkManager&&) = delete;
+
+  /// The default instance, created on first use
   static NetworkManager& get();
 
-  void gather_stats(opmonlib::InfoCollector& ci, int /*level*/);
+  /**
+   * @brief Report statistics, in more detail the higher the level.
+   *
+   * Level 0 only reports the totals over all connections (and the arena); from
+   * s_connection_stats_level on, each connection or topic with news since its previous report is
+   * reported too, and s_latency_stats_level and s_lock_stats_level add further detail.
+   */
+  void gather_stats(opmonlib::InfoCollector& ci, int level);
   void configure(const nwmgr::Connections& connections);
+  /**
+   * @brief Stop all Listeners, close all plugins and forget the configuration.
+   *
+   * All Listeners are told to stop at once and then waited for together, and the plugins are closed
+   * on s_teardown_threads threads. If this takes longer than s_teardown_timeout, a TeardownIncomplete
+   * warning is issued: Listeners still in a callback are then waited for regardless, since they use
+   * this NetworkManager, while the plugins left are closed in the background. The next configure(),
+   * or the destructor, waits for those to be closed.
+   */
   void reset();
 
+  /**
+   * @brief Create the message arena (or remove it, if conf.size is 0), until the next reset().
+   *
+   * Like configure(), this must not be called concurrently with sends.
+   */
+  void configure_arena(const nwmgr::Arena& conf);
+
+  /// A buffer for a message, from the arena if one is configured and has room, otherwise from the heap
+  ArenaBuffer allocate_buffer(size_t size);
+
   // Receive via callback
   void start_listening(std::string const& connection_name);
   void stop_listening(std::string const& connection_name);
+  /// Stop listening once the messages already queued have been delivered, waiting at most drain_timeout for
+  /// them (see Listener::stop_listening); returns how many were delivered and whether any were left.
+  /// start_listening (or subscribe) on the same connection, and reset(), wait for the drain to finish.
+  Listener::DrainResult stop_listening(std::string const& connection_name, std::chrono::milliseconds drain_timeout);
   [[deprecated("Use IOManager.get_receiver instead")]] void register_callback(
     std::string const& connection_or_topic,
     std::function<void(ipm::Receiver::Response)> callback);
+  /// Like register_callback, but running the callback on worker_count threads; messages for which
+  /// key_extractor returns the same key are processed in the order they were received
+  [[deprecated("Use IOManager.get_receiver instead")]] void register_callback(
+    std::string const& connection_or_topic,
+    std::function<void(ipm::Receiver::Response)> callback,
+    KeyedDispatcher::key_extractor_t key_extractor,
+    size_t worker_count);
   void clear_callback(std::string const& connection_or_topic);
+  /// Answer the requests arriving on a listening connection with the replies computed by handler,
+  /// which are sent on the connection's reply_connection
+  [[deprecated("Use IOManager.get_receiver instead")]] void register_request_handler(
+    std::string const& connection_name,
+    request_handler_t handler);
   void subscribe(std::string const& topic);
   void unsubscribe(std::string const& topic);
 
@@ -66,12 +163,38 @@ public:
                                                                   size_t size,
                                                                   ipm::Sender::duration_t timeout,
                                                                   std::string const& topic = "");
+  /**
+   * @brief Send a message to every connection declaring the given topic, to all of them at once.
+   *
+   * The first connection is sent to on the calling thread, and the others on the threads of a pool
+   * of up to s_publish_threads, so that connections which block until timeout do so together.
+   * Returns once every send has completed or failed (e.g. timed out), with the names of the
+   * connections to which the message could not be sent.
+   */
+  [[deprecated("Use IOManager.get_sender instead")]] std::vector<std::string> publish(std::string const& topic,
+                                                                                      const void* buffer,
+                                                                                      size_t size,
+                                                                                      ipm::Sender::duration_t timeout);
+  /**
+   * @brief Send a request, returning a future for its reply.
+   *
+   * The reply arrives on the connection's reply_connection, on which NetworkManager listens itself
+   * from the first request on, and is matched to its request by correlation ID. The future fails
+   * with RequestTimedOut if there is no reply within timeout (which also limits the send), and with
+   * the send's error if the request could not be sent.
+   */
+  [[deprecated("Use IOManager.get_sender instead")]] std::future<ipm::Receiver::Response> request(
+    std::string const& connection_name,
+    const void* buffer,
+    size_t size,
+    ipm::Sender::duration_t timeout);
   [[deprecated("Use IOManager.get_receiver instead")]] ipm::Receiver::Response receive_from(
     std::string const& connection_or_topic,
     ipm::Receiver::duration_t timeout);
 
-  std::string get_connection_string(std::string const& connection_name) const;
-  std::vector<std::string> get_connection_strings(std::string const& topic) const;
+  // The references returned by these remain valid until reset()
+  std::string const& get_connection_string(std::string const& connection_name) const;
+  std::vector<std::string> const& get_connection_strings(std::string const& topic) const;
 
   bool is_topic(std::string const& topic) const;
   bool is_connection(std::string const& connection_name) const;
@@ -86,30 +209,156 @@ public:
   std::shared_ptr<ipm::Subscriber> get_subscriber(std::string const& topic);
 
 private:
+  friend class Listener;
+
   static std::unique_ptr<NetworkManager> s_instance;
+  static std::once_flag s_instance_flag;
+  // Advanced by every reset(), invalidating the per-thread plugin caches of all instances
+  static std::atomic<uint64_t> s_plugin_epoch;
 
-  NetworkManager() = default;
+  /// How a connection or topic name is used, worked out once by configure()
+  struct Resolution
+  {
+    enum class Kind
+    {
+      Connection,       ///< Point-to-point connection
+      PubSubConnection, ///< Connection declaring topics
+      Topic
+    };
 
-  NetworkManager(NetworkManager const&) = delete;
-  NetworkManager(NetworkManager&&) = delete;
-  NetworkManager& operator=(NetworkManager const&) = delete;
-  NetworkManager& operator=(NetworkManager&&) = delete;
+    Kind kind;
+    /// The connection's address, or those of all connections declaring the topic
+    std::vector<std::string> addresses;
+    /// For topics, the connections declaring it, in configuration order
+    std::vector<std::string> connections;
+    /// Topics a receiver subscribes to: the topic itself, or the connection's topics
+    std::vector<std::string> subscriptions;
+    /// Tuning keys added to the config of the plugins created for the name
+    nlohmann::json tuning;
+    /// For wildcard subscriptions, the pattern against which each received message's topic is matched
+    std::optional<TopicPattern> pattern;
+  };
 
+  /// A wildcard subscription, resolved against the configured topics by subscribe or get_subscriber
+  struct PatternSubscription
+  {
+    Resolution resolution;
+    std::unique_ptr<ConnectionStats> stats;
+  };
+
+  // nullptr if the name is neither a connection nor a topic, nor a registered pattern
+  Resolution const* find_resolution(std::string const& connection_or_topic) const;
+  // The subscription of a registered pattern, or nullptr
+  PatternSubscription* find_pattern_subscription(std::string const& pattern) const;
+  // Find, or resolve and add, the subscription of a pattern; nullptr if the pattern matches no topic
+  PatternSubscription* register_pattern(std::string const& pattern);
+  // The resolution of a topic, or pattern, which the given connections declare
+  Resolution resolve_topic(std::vector<std::string> const& connection_names) const;
+  // The statistics, with the merged Listener settings, of a topic or pattern which the given connections declare
+  std::unique_ptr<ConnectionStats> make_topic_stats(std::vector<std::string> const& connection_names) const;
+
+  void start_listener(std::string const& connection_or_topic);
+  // Wait for a stop_listening of the connection or topic to finish draining; lk holds m_registration_mutex
+  void wait_for_drain(std::unique_lock<InstrumentedMutex>& lk, std::string const& connection_or_topic);
   bool is_listening_locked(std::string const& connection_or_topic) const;
+  // Strip the envelope from a message; returns false if the message was a chunk which did not complete a message,
+  // or an invalid chunk
+  bool open_envelope(std::string const& connection_or_topic,
+                     ipm::Receiver::Response& response,
+                     EnvelopeStats& envelope) const;
+  void update_sequence(EnvelopeStats& envelope, EnvelopeHeader const& header, std::string const& topic) const;
   void create_receiver(std::string const& connection_or_topic);
   void create_sender(std::string const& connection_name);
+  // Create a sender plugin and connect it to the connection's address of index first_index (0 is the primary
+  // address, then come the alternates), or else to each following one in turn. Returns the plugin and the index
+  // of the address it connected to, or rethrows the error of the last address tried.
+  std::pair<std::shared_ptr<ipm::Sender>, size_t> connect_sender(std::string const& connection_name,
+                                                                 size_t first_index) const;
+  // Put a connected plugin in the map, which m_sender_plugin_map_mutex must guard
+  void install_sender(std::string const& connection_name, std::shared_ptr<ipm::Sender> plugin, size_t address_index);
+  // Called on the Reconnector thread
+  bool reconnect_sender(std::string const& connection_name);
+  // After a send failed, reconnect (to the next address) in the background, if the connection has alternate addresses
+  void fail_over_sender(std::string const& connection_name);
+  // Send a message, with its envelope if there is one, in chunks of chunk_size if it is larger than that.
+  // send_lock is the connection lock, which is released between chunks, so sender_ptr must not refer to the
+  // plugin map.
+  void send_message(std::unique_lock<InstrumentedMutex>& send_lock,
+                    std::shared_ptr<ipm::Sender> const& sender_ptr,
+                    EnvelopeStats* envelope,
+                    size_t chunk_size,
+                    const void* buffer,
+                    size_t size,
+                    ipm::Sender::duration_t timeout,
+                    std::string const& topic);
+  // Send one message, or one chunk if chunk is not nullptr, after its envelope
+  void send_enveloped(std::shared_ptr<ipm::Sender> const& sender_ptr,
+                      EnvelopeHeader header,
+                      ChunkHeader const* chunk,
+                      const void* buffer,
+                      size_t size,
+                      ipm::Sender::duration_t timeout,
+                      std::string const& topic);
+  void start_reply_listener(std::string const& connection_name, RequestTracker& tracker);
+  void handle_request(std::string const& connection_name,
+                      std::string const& reply_connection,
+                      request_handler_t const& handler,
+                      ipm::Receiver::Response&& request);
+
+  // Find (creating it if needed) the plugin for a connection through a per-thread cache, without locking
+  // once the plugin has been cached. The reference is valid until reset().
+  std::shared_ptr<ipm::Sender> const& get_sender_plugin(std::string const& connection_name);
+  std::shared_ptr<ipm::Receiver> const& get_receiver_plugin(std::string const& connection_or_topic);
+  ConnectionStats* get_connection_stats(std::string const& connection_or_topic) const;
 
   std::unordered_map<std::string, nwmgr::Connection> m_connection_map;
   std::unordered_map<std::string, std::vector<std::string>> m_topic_map;
+  std::unordered_map<std::string, Resolution> m_resolutions;
+  TopicTrie m_topic_trie;
+  // Added to by register_pattern; guarded by m_pattern_mutex
+  mutable std::unordered_map<std::string, PatternSubscription> m_pattern_subscriptions;
   std::unordered_map<std::string, std::shared_ptr<ipm::Receiver>> m_receiver_plugins;
   std::unordered_map<std::string, std::shared_ptr<ipm::Sender>> m_sender_plugins;
-  std::unordered_map<std::string, Listener> m_registered_listeners;
+  // Owned through pointers, since a running Listener's thread refers to it, and stop_listening drains it without
+  // m_registration_mutex
+  std::unordered_map<std::string, std::unique_ptr<Listener>> m_registered_listeners;
+  // Listeners being drained by stop_listening, which start_listener and reset() wait for; guarded by
+  // m_registration_mutex
+  std::unordered_set<std::string> m_draining_listeners;
+  std::condition_variable_any m_drained_cv;
+  std::unordered_map<std::string, std::unique_ptr<ConnectionStats>> m_connection_stats;
+  std::unordered_map<std::string, std::unique_ptr<RequestTracker>> m_request_trackers;
+  // Totals reported by the previous gather_stats, from which the total rates are computed; guarded by m_stats_mutex
+  connectioninfo::Info m_last_totals;
+  std::chrono::steady_clock::time_point m_last_totals_time{ std::chrono::steady_clock::now() };
+  std::shared_ptr<MessageArena> m_arena{ nullptr };
+
+  std::unique_lock<InstrumentedMutex> get_connection_lock(std::string const& connection_name) const;
+  void gather_lock_stats(opmonlib::InfoCollector& ci,
+                         std::unordered_map<std::string, connectioninfo::LockInfo>& connection_locks,
+                         std::unordered_map<std::string, connectioninfo::LockInfo>& callback_locks);
+  mutable std::unordered_map<std::string, InstrumentedMutex> m_connection_mutexes;
+  mutable InstrumentedMutex m_connection_map_mutex;
+  mutable InstrumentedMutex m_receiver_plugin_map_mutex;
+  mutable InstrumentedMutex m_sender_plugin_map_mutex;
+  mutable InstrumentedMutex m_registration_mutex;
+  mutable std::mutex m_stats_mutex;
+  mutable std::mutex m_pattern_mutex;
+
+  // Threads which a reset() left closing plugins past its deadline; guarded by m_registration_mutex
+  std::vector<std::thread> m_teardown_threads;
+  void join_teardown_threads();
+
+  // Identifies this NetworkManager, for one configuration, in message envelopes: sequence numbers restart
+  // with each configure(), so peers must see them as coming from a new sender
+  uint64_t m_sender_id{ generate_sender_id() };
+  static uint64_t generate_sender_id();
+
+  // Idle between publish() calls, which wait for their sends
+  WorkerPool m_publish_pool{ s_publish_threads };
 
-  std::unique_lock<std::mutex> get_connection_lock(std::string const& connection_name) const;
-  mutable std::unordered_map<std::string, std::mutex> m_connection_mutexes;
-  mutable std::mutex m_receiver_plugin_map_mutex;
-  mutable std::mutex m_sender_plugin_map_mutex;
-  mutable std::mutex m_registration_mutex;
+  // Last, so that its thread stops before anything it uses is destroyed
+  Reconnector m_reconnector{ [this](std::string const& connection_name) { return reconnect_sender(connection_name); } };
 };
 } // namespace networkmanager
 } // namespace dunedaq
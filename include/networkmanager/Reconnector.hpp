@@ -0,0 +1,84 @@
+/**
+ *
+ * @file Reconnector.hpp Background retries, with exponential backoff, of failed connects
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_RECONNECTOR_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_RECONNECTOR_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Runs reconnect attempts for named connections on a background thread.
+ *
+ * Each scheduled connection is retried until an attempt succeeds, waiting twice as long after
+ * each failed attempt, up to a maximum. The thread is only started when first needed.
+ */
+class Reconnector
+{
+public:
+  /// Makes one reconnect attempt for the named connection, returning whether it succeeded
+  using attempt_t = std::function<bool(std::string const&)>;
+
+  explicit Reconnector(attempt_t attempt);
+  ~Reconnector();
+
+  Reconnector(Reconnector const&) = delete;
+  Reconnector(Reconnector&&) = delete;
+  Reconnector& operator=(Reconnector const&) = delete;
+  Reconnector& operator=(Reconnector&&) = delete;
+
+  /**
+   * @brief Start retrying the named connection, unless it is already scheduled.
+   *
+   * The first attempt is made after first_delay, and failed attempts are retried after backoff,
+   * doubling up to max_backoff.
+   */
+  void schedule(std::string const& name,
+                std::chrono::milliseconds first_delay,
+                std::chrono::milliseconds backoff,
+                std::chrono::milliseconds max_backoff);
+
+  bool is_scheduled(std::string const& name) const;
+
+  /// Drop all scheduled connections, waiting for an attempt in progress to finish
+  void clear();
+
+private:
+  struct Task
+  {
+    std::chrono::steady_clock::time_point next_attempt;
+    std::chrono::milliseconds backoff;
+    std::chrono::milliseconds max_backoff;
+  };
+
+  void thread_loop();
+
+  attempt_t m_attempt;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_changed;
+  std::map<std::string, Task> m_tasks;
+  std::string m_attempt_in_progress; // Name of the connection being attempted, empty if none is
+  uint64_t m_generation{ 0 };        // Advanced by clear(), so that an attempt in progress is not rescheduled
+  bool m_stop{ false };
+  std::thread m_thread;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_RECONNECTOR_HPP_
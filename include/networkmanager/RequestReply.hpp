@@ -0,0 +1,136 @@
+/**
+ *
+ * @file RequestReply.hpp Correlation of requests and replies exchanged over a pair of connections
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_REQUESTREPLY_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_REQUESTREPLY_HPP_
+
+#include "networkmanager/connectioninfo/InfoStructs.hpp"
+
+#include "ipm/Receiver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Header prepended to requests and replies, carrying the correlation ID which pairs them up.
+ *
+ * It sits inside the message payload, so it is independent of (and inside of) any envelope.
+ */
+struct RequestHeader
+{
+  static constexpr uint32_t s_magic = 0x514d574e; // "NWMQ"
+  static constexpr uint16_t s_version = 1;
+  static constexpr size_t s_size = 16;
+
+  enum class Kind : uint16_t
+  {
+    Request = 1,
+    Reply = 2
+  };
+
+  uint32_t magic = s_magic;
+  uint16_t version = s_version;
+  Kind kind = Kind::Request;
+  uint64_t correlation_id = 0;
+
+  /// Write the header in its wire format; destination must have room for s_size bytes
+  void write(char* destination) const;
+
+  /// Read a header from the start of data, returning false if data does not start with a valid header
+  bool read(const char* data, size_t size);
+};
+
+/**
+ * @brief Table of the requests sent over one connection which are still waiting for their replies.
+ *
+ * Each request gets a correlation ID and a future for its reply. The upper half of the ID is drawn
+ * at random for each tracker, so that a reply meant for an earlier tracker (e.g. from before a
+ * reset) or another requester is not taken for a reply to one of its own requests. A background
+ * thread, started with the first request which has a timeout, fails the futures of requests whose
+ * timeout expires with RequestTimedOut; destroying the tracker fails those still pending with
+ * RequestCancelled.
+ */
+class RequestTracker
+{
+public:
+  struct PendingRequest
+  {
+    uint64_t correlation_id;
+    std::future<ipm::Receiver::Response> reply;
+  };
+
+  explicit RequestTracker(std::string const& name);
+  ~RequestTracker();
+
+  RequestTracker(RequestTracker const&) = delete;
+  RequestTracker(RequestTracker&&) = delete;
+  RequestTracker& operator=(RequestTracker const&) = delete;
+  RequestTracker& operator=(RequestTracker&&) = delete;
+
+  /// Register a new request, which times out after the given time (never, for ipm::Receiver::s_block)
+  PendingRequest add(std::chrono::milliseconds timeout);
+
+  /// Fail a pending request, e.g. because it could not be sent
+  void fail(uint64_t correlation_id, std::exception_ptr error);
+
+  /// Hand a reply to its request, returning false if no request with that correlation ID is pending
+  bool complete(uint64_t correlation_id, ipm::Receiver::Response&& reply);
+
+  size_t pending() const;
+  void fill_info(connectioninfo::RequestInfo& info) const;
+
+  bool reply_listener_started() const { return m_reply_listener_started.load(std::memory_order_acquire); }
+  void set_reply_listener_started() { m_reply_listener_started.store(true, std::memory_order_release); }
+
+private:
+  struct Entry
+  {
+    std::promise<ipm::Receiver::Response> promise;
+    std::chrono::milliseconds timeout;
+    std::multimap<std::chrono::steady_clock::time_point, uint64_t>::iterator deadline;
+    bool has_deadline;
+  };
+
+  void expiry_loop();
+  // Remove an entry and its deadline; m_mutex must be held
+  void erase(std::unordered_map<uint64_t, Entry>::iterator entry_it);
+
+  std::string m_name;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_deadline_changed;
+  std::unordered_map<uint64_t, Entry> m_pending;
+  std::multimap<std::chrono::steady_clock::time_point, uint64_t> m_deadlines;
+  uint64_t m_next_correlation_id;
+  bool m_stop{ false };
+
+  std::atomic<uint64_t> m_completed{ 0 };
+  std::atomic<uint64_t> m_timed_out{ 0 };
+  std::atomic<uint64_t> m_late_replies{ 0 };
+  std::atomic<bool> m_reply_listener_started{ false };
+
+  std::thread m_expiry_thread; // Guarded by m_mutex until the destructor joins it
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_REQUESTREPLY_HPP_
@@ -0,0 +1,134 @@
+/**
+ *
+ * @file StripedTransport.hpp Senders and receivers spreading one connection over several sockets
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_STRIPEDTRANSPORT_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_STRIPEDTRANSPORT_HPP_
+
+#include "networkmanager/nwmgr/Structs.hpp"
+
+#include "ipm/Receiver.hpp"
+#include "ipm/Sender.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Sender spreading the messages of one connection over several sender plugins (stripes).
+ *
+ * connect_for_sends takes the stripes' addresses as "connection_strings", one per stripe, and
+ * connects each stripe with the rest of the config and its own address as "connection_string".
+ * With StripePolicy::round_robin, each message goes to the next stripe in turn. With
+ * StripePolicy::least_loaded, the stripes are offered the message without waiting, starting with
+ * the next one in turn, and only if none can take it straight away does the send wait on that one.
+ */
+class StripedSender : public ipm::Sender
+{
+public:
+  StripedSender(std::vector<std::shared_ptr<ipm::Sender>> stripes, nwmgr::StripePolicy policy);
+
+  void connect_for_sends(const nlohmann::json& connection_info) override;
+  bool can_send() const noexcept override;
+
+  size_t stripe_count() const { return m_stripes.size(); }
+
+protected:
+  void send_(const void* message, message_size_t N, const duration_t& timeout, std::string const& metadata) override;
+
+private:
+  std::vector<std::shared_ptr<ipm::Sender>> m_stripes;
+  nwmgr::StripePolicy m_policy;
+  std::atomic<size_t> m_next_stripe{ 0 };
+};
+
+/**
+ * @brief Receiver merging the stripes of a connection into one stream.
+ *
+ * Stripes are polled in turn, so that a busy stripe does not starve the others. Messages from
+ * different stripes may overtake each other; an ordered StripedReceiver puts them back in the order
+ * they were sent, using the sequence numbers of their envelopes. Messages which arrive ahead of
+ * their turn are held back until the missing ones arrive, or for at most s_reorder_window, after
+ * which the missing messages are given up as lost. Messages without a valid envelope are passed
+ * on straight away.
+ */
+class StripedReceiver : public ipm::Receiver
+{
+public:
+  /// How long a message may be held back waiting for earlier ones
+  static constexpr std::chrono::milliseconds s_reorder_window{ 10 };
+  /// Messages held back for a single sender at most, before the missing ones are given up
+  static constexpr size_t s_reorder_capacity = 10000;
+  /// Longest wait on any one stripe while all are idle, which bounds the delay of a message on another
+  static constexpr std::chrono::milliseconds s_stripe_wait{ 1 };
+
+  StripedReceiver(std::vector<std::shared_ptr<ipm::Receiver>> stripes, bool ordered);
+
+  void connect_for_receives(const nlohmann::json& connection_info) override;
+  bool can_receive() const noexcept override;
+
+  size_t stripe_count() const { return m_stripes.size(); }
+
+protected:
+  Response receive_(const duration_t& timeout) override;
+
+private:
+  // A message, or one chunk of a chunked message, held back until its turn
+  struct Held
+  {
+    Response response;
+    std::chrono::steady_clock::time_point arrival_time;
+    uint64_t chunk_size = 0;   // Size of the chunk's data
+    uint64_t message_size = 0; // Size of the whole message the chunk belongs to, or 0 if it is not a chunk
+  };
+
+  // Messages of one sender and topic, which are numbered independently of the others. All chunks of
+  // a message share its sequence number, so the turn only moves on once they have all been passed on.
+  struct Stream
+  {
+    uint64_t next_sequence_number = 0;
+    uint64_t next_bytes_passed = 0; // Chunk data of the message whose turn it is passed on so far
+    std::map<std::pair<uint64_t, uint64_t>, Held> held; // By sequence number and chunk offset
+  };
+
+  // One receive from each stripe in turn without waiting, then, if none had a message, a wait of up to
+  // timeout on the next stripe in turn
+  bool poll(Response& response, duration_t timeout);
+  // Hold back a message which is ahead of its turn; returns false if it is to be delivered now
+  bool hold(Response& response, std::chrono::steady_clock::time_point now);
+  // Take the next held message which is due, if any
+  bool pop_due(Response& response, std::chrono::steady_clock::time_point now);
+  // Pass on a message or chunk whose turn it is, moving the turn on once its message is complete
+  static void take_turn(Stream& stream, uint64_t chunk_size, uint64_t message_size);
+  // How long until the first held message is due regardless of the missing ones
+  duration_t time_to_next_due(std::chrono::steady_clock::time_point now) const;
+
+  std::vector<std::shared_ptr<ipm::Receiver>> m_stripes;
+  bool m_ordered;
+  size_t m_next_stripe{ 0 };
+
+  std::mutex m_mutex;
+  std::map<std::pair<uint64_t, std::string>, Stream> m_streams;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_STRIPEDTRANSPORT_HPP_
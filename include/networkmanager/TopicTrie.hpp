@@ -0,0 +1,85 @@
+/**
+ *
+ * @file TopicTrie.hpp Wildcard topic patterns and the trie of configured topics they are resolved against
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_TOPICTRIE_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_TOPICTRIE_HPP_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief A topic name in which each s_wildcard stands for any run of characters, e.g. "TPSets_*".
+ *
+ * Matching a topic against the pattern does not allocate, so that it can be done for every message.
+ */
+class TopicPattern
+{
+public:
+  static constexpr char s_wildcard = '*';
+
+  /// Whether a name contains a wildcard, rather than naming a single topic
+  static bool is_pattern(std::string_view name) noexcept { return name.find(s_wildcard) != std::string_view::npos; }
+
+  explicit TopicPattern(std::string pattern);
+
+  std::string const& str() const { return m_pattern; }
+  /// The part before the first wildcard, with which every matching topic starts
+  std::string_view prefix() const { return std::string_view(m_pattern).substr(0, m_prefix_size); }
+
+  bool matches(std::string_view topic) const noexcept;
+
+private:
+  std::string m_pattern;
+  size_t m_prefix_size;
+};
+
+/**
+ * @brief The topics of a configuration, by prefix.
+ *
+ * Built by NetworkManager::configure, and read without locking afterwards. A pattern is resolved by
+ * walking down to the node of its prefix and matching only the topics below it.
+ */
+class TopicTrie
+{
+public:
+  void insert(std::string const& topic);
+  void clear();
+
+  size_t size() const { return m_size; }
+
+  /// The topics which the pattern matches, in lexicographic order
+  std::vector<std::string> match(TopicPattern const& pattern) const;
+
+private:
+  struct Node
+  {
+    std::map<char, std::unique_ptr<Node>> children;
+    bool is_topic = false;
+  };
+
+  void collect(Node const& node,
+               std::string& topic,
+               TopicPattern const& pattern,
+               std::vector<std::string>& matches) const;
+
+  Node m_root;
+  size_t m_size{ 0 };
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_TOPICTRIE_HPP_
@@ -0,0 +1,62 @@
+/**
+ *
+ * @file WorkerPool.hpp Persistent threads running short tasks, such as the sends of a publish
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef NETWORKMANAGER_INCLUDE_NETWORKMANAGER_WORKERPOOL_HPP_
+#define NETWORKMANAGER_INCLUDE_NETWORKMANAGER_WORKERPOOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+namespace networkmanager {
+
+/**
+ * @brief Runs tasks on up to max_threads threads, which are kept for later tasks.
+ *
+ * A thread is only started when a task is submitted while all threads are busy, so the pool
+ * grows to the number of tasks that have had to run at the same time. Tasks beyond max_threads
+ * wait their turn. Tasks must not throw.
+ */
+class WorkerPool
+{
+public:
+  explicit WorkerPool(size_t max_threads);
+  /// Runs the tasks still queued, then stops the threads
+  ~WorkerPool();
+
+  WorkerPool(WorkerPool const&) = delete;
+  WorkerPool(WorkerPool&&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool&&) = delete;
+
+  void submit(std::function<void()> task);
+
+  size_t thread_count() const;
+
+private:
+  void thread_loop();
+
+  size_t m_max_threads;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_changed;
+  std::deque<std::function<void()>> m_tasks;
+  size_t m_idle_threads{ 0 };
+  bool m_stop{ false };
+  std::vector<std::thread> m_threads;
+};
+
+} // namespace networkmanager
+} // namespace dunedaq
+
+#endif // NETWORKMANAGER_INCLUDE_NETWORKMANAGER_WORKERPOOL_HPP_
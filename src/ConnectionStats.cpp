@@ -0,0 +1,162 @@
+/**
+ *
+ * @file ConnectionStats.cpp NetworkManager per-connection statistics
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/ConnectionStats.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include <string>
+
+namespace dunedaq::networkmanager {
+
+void
+ListenerActivity::check_callback_duration(std::string const& name,
+                                          std::chrono::steady_clock::duration duration,
+                                          std::chrono::steady_clock::time_point now)
+{
+  if (callback_budget.count() == 0 || duration <= callback_budget) {
+    return;
+  }
+
+  auto overruns = callback_overruns.fetch_add(1, std::memory_order_relaxed) + 1;
+  auto now_ns = to_ns(now);
+  auto last_warning_ns = last_overrun_warning_ns.load(std::memory_order_relaxed);
+  if (now_ns - last_warning_ns >= std::chrono::nanoseconds(s_overrun_warning_interval).count() &&
+      last_overrun_warning_ns.compare_exchange_strong(last_warning_ns, now_ns, std::memory_order_relaxed)) {
+    ers::warning(CallbackOverrun(ERS_HERE,
+                                 name,
+                                 std::chrono::duration<double, std::milli>(duration).count(),
+                                 std::chrono::duration<double, std::milli>(callback_budget).count(),
+                                 overruns));
+  }
+}
+
+ConnectionStats::ConnectionStats()
+  : m_last_time(std::chrono::steady_clock::now())
+{}
+
+LatencyHistograms&
+ConnectionStats::enable_latency_histograms()
+{
+  if (!m_latency_storage) {
+    m_latency_storage = std::make_unique<LatencyHistograms>();
+  } else if (latency() == nullptr) {
+    m_latency_storage->send_time.collect_and_reset();
+    m_latency_storage->lock_wait.collect_and_reset();
+    m_latency_storage->dispatch_delay.collect_and_reset();
+    m_latency_storage->callback_time.collect_and_reset();
+  }
+  m_latency.store(m_latency_storage.get(), std::memory_order_release);
+  return *m_latency_storage;
+}
+
+void
+ConnectionStats::fill_counters(connectioninfo::Info& info) const
+{
+  info.sent_bytes = m_sent.bytes.load(std::memory_order_relaxed);
+  info.sent_messages = m_sent.messages.load(std::memory_order_relaxed);
+  info.received_bytes = m_received.bytes.load(std::memory_order_relaxed);
+  info.received_messages = m_received.messages.load(std::memory_order_relaxed);
+  if (m_envelope) {
+    info.missing_messages = m_envelope->missing_messages.load(std::memory_order_relaxed);
+    info.out_of_order_messages = m_envelope->out_of_order_messages.load(std::memory_order_relaxed);
+    info.invalid_envelopes = m_envelope->invalid_envelopes.load(std::memory_order_relaxed);
+    info.chunks_sent = m_envelope->chunks_sent.load(std::memory_order_relaxed);
+    info.chunks_received = m_envelope->chunks_received.load(std::memory_order_relaxed);
+    info.abandoned_messages = m_envelope->reassembler.abandoned_messages();
+  }
+
+  info.failovers = m_sender_health.failovers.load(std::memory_order_relaxed);
+  info.reconnects = m_sender_health.reconnects.load(std::memory_order_relaxed);
+  info.callback_overruns = m_listener_activity.callback_overruns.load(std::memory_order_relaxed);
+  info.busy_poll_us = m_listener_activity.busy_poll_ns.load(std::memory_order_relaxed) / 1e3;
+  info.busy_poll_hits = m_listener_activity.busy_poll_hits.load(std::memory_order_relaxed);
+  info.busy_poll_misses = m_listener_activity.busy_poll_misses.load(std::memory_order_relaxed);
+}
+
+void
+ConnectionStats::add_to_totals(connectioninfo::Info& totals) const
+{
+  connectioninfo::Info info;
+  fill_counters(info);
+  totals.sent_bytes += info.sent_bytes;
+  totals.sent_messages += info.sent_messages;
+  totals.received_bytes += info.received_bytes;
+  totals.received_messages += info.received_messages;
+  totals.missing_messages += info.missing_messages;
+  totals.out_of_order_messages += info.out_of_order_messages;
+  totals.invalid_envelopes += info.invalid_envelopes;
+  totals.chunks_sent += info.chunks_sent;
+  totals.chunks_received += info.chunks_received;
+  totals.abandoned_messages += info.abandoned_messages;
+  totals.failovers += info.failovers;
+  totals.reconnects += info.reconnects;
+  totals.callback_overruns += info.callback_overruns;
+  totals.busy_poll_us += info.busy_poll_us;
+  totals.busy_poll_hits += info.busy_poll_hits;
+  totals.busy_poll_misses += info.busy_poll_misses;
+}
+
+void
+ConnectionStats::fill_rates(connectioninfo::Info& info, connectioninfo::Info const& last_info, double seconds)
+{
+  if (seconds > 0.) {
+    info.sent_byte_rate = (info.sent_bytes - last_info.sent_bytes) / seconds;
+    info.sent_message_rate = (info.sent_messages - last_info.sent_messages) / seconds;
+    info.received_byte_rate = (info.received_bytes - last_info.received_bytes) / seconds;
+    info.received_message_rate = (info.received_messages - last_info.received_messages) / seconds;
+  }
+
+  auto busy_poll_hits = info.busy_poll_hits - last_info.busy_poll_hits;
+  auto busy_poll_periods = busy_poll_hits + info.busy_poll_misses - last_info.busy_poll_misses;
+  if (busy_poll_periods > 0) {
+    info.busy_poll_hit_ratio = static_cast<double>(busy_poll_hits) / busy_poll_periods;
+  }
+}
+
+bool
+ConnectionStats::changed_since_last_info(std::chrono::steady_clock::time_point now) const
+{
+  // A callback in progress, and rates which have not yet been reported as zero, are news too
+  if (now - m_last_time >= s_idle_report_interval ||
+      m_listener_activity.callback_start_ns.load(std::memory_order_relaxed) != 0 ||
+      m_last_info.sent_message_rate != 0. || m_last_info.received_message_rate != 0.) {
+    return true;
+  }
+
+  connectioninfo::Info info;
+  fill_counters(info);
+  return info.sent_messages != m_last_info.sent_messages || info.received_messages != m_last_info.received_messages ||
+         info.missing_messages != m_last_info.missing_messages ||
+         info.out_of_order_messages != m_last_info.out_of_order_messages ||
+         info.invalid_envelopes != m_last_info.invalid_envelopes || info.chunks_sent != m_last_info.chunks_sent ||
+         info.chunks_received != m_last_info.chunks_received ||
+         info.abandoned_messages != m_last_info.abandoned_messages || info.failovers != m_last_info.failovers ||
+         info.reconnects != m_last_info.reconnects || info.callback_overruns != m_last_info.callback_overruns ||
+         info.busy_poll_hits != m_last_info.busy_poll_hits || info.busy_poll_misses != m_last_info.busy_poll_misses;
+}
+
+void
+ConnectionStats::fill_info(connectioninfo::Info& info)
+{
+  auto now = std::chrono::steady_clock::now();
+  fill_counters(info);
+
+  auto now_ns = ListenerActivity::to_ns(now);
+  auto last_receive_ns = m_listener_activity.last_receive_ns.load(std::memory_order_relaxed);
+  info.seconds_since_last_receive = last_receive_ns != 0 ? (now_ns - last_receive_ns) / 1e9 : -1.;
+  auto callback_start_ns = m_listener_activity.callback_start_ns.load(std::memory_order_relaxed);
+  info.seconds_in_callback = callback_start_ns != 0 ? (now_ns - callback_start_ns) / 1e9 : 0.;
+
+  fill_rates(info, m_last_info, std::chrono::duration<double>(now - m_last_time).count());
+
+  m_last_info = info;
+  m_last_time = now;
+}
+
+} // namespace dunedaq::networkmanager
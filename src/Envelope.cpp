@@ -0,0 +1,202 @@
+/**
+ *
+ * @file Envelope.cpp Message envelope used for end-to-end latency and loss tracing
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Envelope.hpp"
+
+#include <cstring>
+#include <iterator>
+
+namespace dunedaq::networkmanager {
+
+void
+EnvelopeHeader::write(char* destination) const
+{
+  memcpy(destination, &magic, sizeof(magic));
+  memcpy(destination + 4, &version, sizeof(version));
+  memcpy(destination + 6, &flags, sizeof(flags));
+  memcpy(destination + 8, &sequence_number, sizeof(sequence_number));
+  memcpy(destination + 16, &send_time_ns, sizeof(send_time_ns));
+  memcpy(destination + 24, &sender_id, sizeof(sender_id));
+}
+
+bool
+EnvelopeHeader::read(const char* data, size_t size)
+{
+  if (size < s_size) {
+    return false;
+  }
+
+  memcpy(&magic, data, sizeof(magic));
+  memcpy(&version, data + 4, sizeof(version));
+  if (magic != s_magic || version != s_version) {
+    return false;
+  }
+
+  memcpy(&flags, data + 6, sizeof(flags));
+  memcpy(&sequence_number, data + 8, sizeof(sequence_number));
+  memcpy(&send_time_ns, data + 16, sizeof(send_time_ns));
+  memcpy(&sender_id, data + 24, sizeof(sender_id));
+  return true;
+}
+
+SequenceTracker::Result
+SequenceTracker::update(uint64_t sender_id, std::string const& stream, uint64_t sequence_number)
+{
+  Result result;
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  auto key = std::make_pair(sender_id, stream);
+  auto stream_it = m_streams.find(key);
+  if (stream_it == m_streams.end()) {
+    m_streams[key].last_sequence_number = sequence_number;
+    return result;
+  }
+
+  auto& state = stream_it->second;
+  if (sequence_number > state.last_sequence_number) {
+    result.missing = sequence_number - state.last_sequence_number - 1;
+    if (result.missing > 0) {
+      add_gap(state, state.last_sequence_number + 1, sequence_number - 1);
+    }
+    state.last_sequence_number = sequence_number;
+    return result;
+  }
+
+  result.out_of_order = true;
+  auto gap_it = state.gaps.upper_bound(sequence_number);
+  if (gap_it == state.gaps.begin()) {
+    return result;
+  }
+  --gap_it;
+  auto first = gap_it->first;
+  auto last = gap_it->second;
+  if (sequence_number > last) {
+    // A duplicate, or a message whose gap has been given up
+    return result;
+  }
+
+  result.recovered = true;
+  state.gaps.erase(gap_it);
+  if (first < sequence_number) {
+    add_gap(state, first, sequence_number - 1);
+  }
+  if (sequence_number < last) {
+    add_gap(state, sequence_number + 1, last);
+  }
+  return result;
+}
+
+void
+SequenceTracker::add_gap(Stream& stream, uint64_t first, uint64_t last)
+{
+  stream.gaps.emplace(first, last);
+  if (stream.gaps.size() > s_max_gaps) {
+    stream.gaps.erase(stream.gaps.begin());
+  }
+}
+
+void
+ChunkHeader::write(char* destination) const
+{
+  memcpy(destination, &message_size, sizeof(message_size));
+  memcpy(destination + 8, &offset, sizeof(offset));
+}
+
+bool
+ChunkHeader::read(const char* data, size_t size)
+{
+  if (size < s_size) {
+    return false;
+  }
+
+  memcpy(&message_size, data, sizeof(message_size));
+  memcpy(&offset, data + 8, sizeof(offset));
+  return true;
+}
+
+Reassembler::Result
+Reassembler::add(uint64_t sender_id,
+                 std::string const& stream,
+                 uint64_t sequence_number,
+                 ChunkHeader const& chunk,
+                 const char* chunk_data,
+                 size_t chunk_size,
+                 std::vector<char>& data,
+                 std::chrono::steady_clock::time_point now)
+{
+  Result result;
+  if (chunk_size == 0 || chunk.message_size > max_message_size() || chunk.offset > chunk.message_size ||
+      chunk_size > chunk.message_size - chunk.offset) {
+    result.status = Status::Invalid;
+    return result;
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto key = std::make_tuple(sender_id, stream, sequence_number);
+  auto message_it = m_messages.find(key);
+  if (message_it == m_messages.end()) {
+    // Only look for stale messages when a new one starts, which is rare compared with chunks
+    abandon_stale_messages(now);
+    message_it = m_messages.emplace(key, Message()).first;
+    message_it->second.data.resize(chunk.message_size);
+    result.first_chunk = true;
+  } else if (message_it->second.data.size() != chunk.message_size) {
+    result.status = Status::Invalid;
+    return result;
+  }
+
+  auto& message = message_it->second;
+  auto next_it = message.chunks.lower_bound(chunk.offset);
+  if (next_it != message.chunks.end() && next_it->first == chunk.offset && next_it->second == chunk_size) {
+    // Sent again; counting it twice could complete the message while another chunk is missing
+    return result;
+  }
+  bool overlaps_next = next_it != message.chunks.end() && next_it->first < chunk.offset + chunk_size;
+  bool overlaps_previous =
+    next_it != message.chunks.begin() && std::prev(next_it)->first + std::prev(next_it)->second > chunk.offset;
+  if (overlaps_next || overlaps_previous) {
+    result.status = Status::Invalid;
+    return result;
+  }
+
+  message.chunks.emplace_hint(next_it, chunk.offset, chunk_size);
+  memcpy(message.data.data() + chunk.offset, chunk_data, chunk_size);
+  message.received_bytes += chunk_size;
+  message.last_chunk_time = now;
+  if (message.received_bytes < chunk.message_size) {
+    return result;
+  }
+
+  data = std::move(message.data);
+  m_messages.erase(message_it);
+  result.status = Status::Complete;
+  return result;
+}
+
+size_t
+Reassembler::pending() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_messages.size();
+}
+
+void
+Reassembler::abandon_stale_messages(std::chrono::steady_clock::time_point now)
+{
+  for (auto message_it = m_messages.begin(); message_it != m_messages.end();) {
+    if (now - message_it->second.last_chunk_time >= s_timeout) {
+      message_it = m_messages.erase(message_it);
+      m_abandoned_messages.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      ++message_it;
+    }
+  }
+}
+
+} // namespace dunedaq::networkmanager
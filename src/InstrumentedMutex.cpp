@@ -0,0 +1,96 @@
+/**
+ *
+ * @file InstrumentedMutex.cpp Mutex recording its own contention statistics
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/InstrumentedMutex.hpp"
+
+namespace dunedaq::networkmanager {
+
+namespace {
+void
+update_max(std::atomic<uint64_t>& max, uint64_t value)
+{
+  auto current = max.load(std::memory_order_relaxed);
+  while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+} // namespace
+
+std::atomic<bool> InstrumentedMutex::s_enabled{ false };
+
+void
+InstrumentedMutex::lock()
+{
+  if (!is_enabled()) {
+    m_mutex.lock();
+    m_locked_at = clock_type::time_point();
+    return;
+  }
+
+  if (m_mutex.try_lock()) {
+    record_acquisition(clock_type::now(), 0);
+    return;
+  }
+
+  auto start = clock_type::now();
+  m_mutex.lock();
+  auto locked_at = clock_type::now();
+  record_acquisition(locked_at, std::chrono::duration_cast<std::chrono::nanoseconds>(locked_at - start).count());
+}
+
+bool
+InstrumentedMutex::try_lock()
+{
+  if (!m_mutex.try_lock()) {
+    return false;
+  }
+  if (is_enabled()) {
+    record_acquisition(clock_type::now(), 0);
+  } else {
+    m_locked_at = clock_type::time_point();
+  }
+  return true;
+}
+
+void
+InstrumentedMutex::unlock()
+{
+  auto locked_at = m_locked_at;
+  m_mutex.unlock();
+
+  if (locked_at != clock_type::time_point()) {
+    auto hold_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - locked_at).count();
+    m_hold_ns.fetch_add(hold_ns, std::memory_order_relaxed);
+    update_max(m_max_hold_ns, hold_ns);
+  }
+}
+
+void
+InstrumentedMutex::record_acquisition(clock_type::time_point locked_at, uint64_t wait_ns)
+{
+  m_locked_at = locked_at;
+  m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (wait_ns > 0) {
+    m_contended_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    m_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+    update_max(m_max_wait_ns, wait_ns);
+  }
+}
+
+void
+InstrumentedMutex::fill_info(connectioninfo::LockInfo& info)
+{
+  info.acquisitions = m_acquisitions.exchange(0, std::memory_order_relaxed);
+  info.contended_acquisitions = m_contended_acquisitions.exchange(0, std::memory_order_relaxed);
+  info.wait_us = m_wait_ns.exchange(0, std::memory_order_relaxed) / 1000.;
+  info.max_wait_us = m_max_wait_ns.exchange(0, std::memory_order_relaxed) / 1000.;
+  info.hold_us = m_hold_ns.exchange(0, std::memory_order_relaxed) / 1000.;
+  info.max_hold_us = m_max_hold_ns.exchange(0, std::memory_order_relaxed) / 1000.;
+}
+
+} // namespace dunedaq::networkmanager
@@ -0,0 +1,161 @@
+/**
+ *
+ * @file KeyedDispatcher.cpp Parallel callback dispatch preserving the order of messages with the same key
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/KeyedDispatcher.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include "ers/ers.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+
+namespace dunedaq::networkmanager {
+
+KeyedDispatcher::KeyedDispatcher(callback_t callback,
+                                 key_extractor_t key_extractor,
+                                 size_t worker_count,
+                                 std::string const& name,
+                                 ConnectionStats* stats)
+  : m_callback(std::move(callback))
+  , m_key_extractor(std::move(key_extractor))
+  , m_name(name)
+  , m_stats(stats)
+{
+  worker_count = std::max<size_t>(worker_count, 1);
+  for (size_t idx = 0; idx < worker_count; ++idx) {
+    m_workers.push_back(std::make_unique<Worker>());
+  }
+  for (auto& worker : m_workers) {
+    worker->thread = std::thread([this, &worker = *worker] { worker_loop(worker); });
+  }
+}
+
+KeyedDispatcher::~KeyedDispatcher()
+{
+  for (auto& worker : m_workers) {
+    std::lock_guard<std::mutex> lk(worker->mutex);
+    worker->stop = true;
+    worker->not_empty.notify_all();
+  }
+  for (auto& worker : m_workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+size_t
+KeyedDispatcher::worker_for(uint64_t key) const
+{
+  // Mix the bits first, so that keys which differ only in their high bits, or share a stride
+  // with the worker count, still spread over all workers
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return key % m_workers.size();
+}
+
+void
+KeyedDispatcher::dispatch(ipm::Receiver::Response&& response, std::chrono::steady_clock::time_point received_time)
+{
+  // Called on the Listener thread, where an exception would terminate the process; without its key, the message
+  // cannot be put in order with the others, so it is dropped
+  uint64_t key = 0;
+  try {
+    key = m_key_extractor(response);
+  } catch (std::exception const& ex) {
+    ers::warning(KeyExtractionFailed(ERS_HERE, m_name, ex.what()));
+    return;
+  } catch (...) {
+    ers::warning(KeyExtractionFailed(ERS_HERE, m_name, "unknown exception"));
+    return;
+  }
+
+  auto& worker = *m_workers[worker_for(key)];
+  std::unique_lock<std::mutex> lk(worker.mutex);
+  worker.not_full.wait(lk, [&] { return worker.queue.size() < s_queue_capacity; });
+  worker.queue.push_back({ std::move(response), received_time });
+  worker.not_empty.notify_one();
+}
+
+void
+KeyedDispatcher::worker_loop(Worker& worker)
+{
+  while (true) {
+    Item item;
+    {
+      std::unique_lock<std::mutex> lk(worker.mutex);
+      worker.not_empty.wait(lk, [&] { return worker.stop || !worker.queue.empty(); });
+      if (worker.queue.empty()) {
+        return;
+      }
+      item = std::move(worker.queue.front());
+      worker.queue.pop_front();
+      worker.not_full.notify_one();
+    }
+
+    // An exception escaping here would terminate the process, so a failing callback only costs its message
+    try {
+      run_callback(worker, std::move(item));
+    } catch (std::exception const& ex) {
+      ers::error(CallbackFailed(ERS_HERE, m_name, ex.what()));
+    } catch (...) {
+      ers::error(CallbackFailed(ERS_HERE, m_name, "unknown exception"));
+    }
+  }
+}
+
+void
+KeyedDispatcher::run_callback(Worker& worker, Item&& item)
+{
+  auto latency = m_stats != nullptr ? m_stats->latency() : nullptr;
+  auto start = std::chrono::steady_clock::now();
+  if (latency != nullptr) {
+    latency->dispatch_delay.record(start - item.received_time);
+  }
+  set_callback_start(worker, ListenerActivity::to_ns(start));
+
+  try {
+    m_callback(std::move(item.response));
+  } catch (...) {
+    set_callback_start(worker, 0);
+    throw;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  set_callback_start(worker, 0);
+  if (m_stats != nullptr) {
+    if (latency != nullptr) {
+      latency->callback_time.record(end - start);
+    }
+    m_stats->listener_activity().check_callback_duration(m_name, end - start, end);
+  }
+}
+
+void
+KeyedDispatcher::set_callback_start(Worker& worker, int64_t start_ns)
+{
+  if (m_stats == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(m_callback_start_mutex);
+  worker.callback_start_ns.store(start_ns, std::memory_order_relaxed);
+  int64_t oldest_ns = 0;
+  for (auto& other : m_workers) {
+    auto other_ns = other->callback_start_ns.load(std::memory_order_relaxed);
+    if (other_ns != 0 && (oldest_ns == 0 || other_ns < oldest_ns)) {
+      oldest_ns = other_ns;
+    }
+  }
+  m_stats->listener_activity().callback_start_ns.store(oldest_ns, std::memory_order_relaxed);
+}
+
+} // namespace dunedaq::networkmanager
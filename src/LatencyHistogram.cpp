@@ -0,0 +1,90 @@
+/**
+ *
+ * @file LatencyHistogram.cpp Log-linear latency histogram used by NetworkManager statistics
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/LatencyHistogram.hpp"
+
+namespace dunedaq::networkmanager {
+
+size_t
+LatencyHistogram::bucket_index(uint64_t value)
+{
+  if (value < s_sub_bucket_count) {
+    return value;
+  }
+
+  unsigned msb = 63 - __builtin_clzll(value);
+  if (msb > s_max_exponent) {
+    return s_bucket_count - 1;
+  }
+  unsigned shift = msb - s_sub_bucket_bits;
+  return (shift + 1) * s_sub_bucket_count + ((value >> shift) - s_sub_bucket_count);
+}
+
+uint64_t
+LatencyHistogram::bucket_upper_edge(size_t index)
+{
+  if (index < s_sub_bucket_count) {
+    return index;
+  }
+
+  uint64_t shift = index / s_sub_bucket_count - 1;
+  uint64_t mantissa = index % s_sub_bucket_count + s_sub_bucket_count;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyHistogram::Summary
+LatencyHistogram::collect_and_reset()
+{
+  std::array<uint64_t, s_bucket_count> counts;
+  Summary summary;
+  for (size_t idx = 0; idx < s_bucket_count; ++idx) {
+    counts[idx] = m_buckets[idx].exchange(0, std::memory_order_relaxed);
+    summary.count += counts[idx];
+  }
+  auto sum = m_sum.exchange(0, std::memory_order_relaxed);
+
+  if (summary.count == 0) {
+    return summary;
+  }
+  summary.mean = static_cast<double>(sum) / summary.count;
+
+  const std::array<std::pair<double, double*>, 4> percentiles{
+    { { 0.5, &summary.p50 }, { 0.9, &summary.p90 }, { 0.99, &summary.p99 }, { 0.999, &summary.p999 } }
+  };
+  size_t next_percentile = 0;
+  uint64_t seen = 0;
+  for (size_t idx = 0; idx < s_bucket_count; ++idx) {
+    if (counts[idx] == 0) {
+      continue;
+    }
+    seen += counts[idx];
+    while (next_percentile < percentiles.size() && seen >= percentiles[next_percentile].first * summary.count) {
+      *percentiles[next_percentile].second = bucket_upper_edge(idx);
+      ++next_percentile;
+    }
+    summary.max = bucket_upper_edge(idx);
+  }
+
+  return summary;
+}
+
+void
+LatencyHistogram::fill_info(connectioninfo::LatencyInfo& info)
+{
+  auto summary = collect_and_reset();
+  info.samples = summary.count;
+  info.mean_us = summary.mean / 1000.;
+  info.p50_us = summary.p50 / 1000.;
+  info.p90_us = summary.p90 / 1000.;
+  info.p99_us = summary.p99 / 1000.;
+  info.p999_us = summary.p999 / 1000.;
+  info.max_us = summary.max / 1000.;
+}
+
+} // namespace dunedaq::networkmanager
@@ -17,14 +17,20 @@
 
 namespace dunedaq::networkmanager {
 
+Listener::Listener(NetworkManager* manager)
+  : m_manager(manager)
+{}
+
 Listener::~Listener() noexcept
 {
   shutdown();
 }
 
 Listener::Listener(Listener&& other)
-  : m_connection_name(other.m_connection_name)
+  : m_manager(other.m_manager)
+  , m_connection_name(other.m_connection_name)
   , m_callback(std::move(other.m_callback))
+  , m_dispatcher(std::move(other.m_dispatcher))
   , m_listener_thread(std::move(other.m_listener_thread))
   , m_is_listening(other.m_is_listening.load())
 {}
@@ -32,8 +38,10 @@ Listener::Listener(Listener&& other)
 Listener&
 Listener::operator=(Listener&& other)
 {
+  m_manager = other.m_manager;
   m_connection_name = other.m_connection_name;
   m_callback = std::move(other.m_callback);
+  m_dispatcher = std::move(other.m_dispatcher);
   m_listener_thread = std::move(other.m_listener_thread);
   m_is_listening = other.m_is_listening.load();
   return *this;
@@ -61,18 +69,62 @@ Listener::stop_listening()
     ers::warning(OperationFailed(ERS_HERE, "Listener is not running"));
 }
 
+Listener::DrainResult
+Listener::stop_listening(std::chrono::milliseconds drain_timeout)
+{
+  if (!is_listening()) {
+    ers::warning(OperationFailed(ERS_HERE, "Listener is not running"));
+    return DrainResult();
+  }
+
+  // Read by the thread once it sees the stop request
+  m_drain_deadline = std::chrono::steady_clock::now() + drain_timeout;
+  shutdown();
+  m_drain_deadline.reset();
+  return m_drain_result;
+}
+
 void
 Listener::set_callback(std::function<void(ipm::Receiver::Response)> callback)
 {
-  std::lock_guard<std::mutex> lk(m_callback_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_callback_mutex);
+  m_dispatcher.reset();
   m_callback = callback;
 }
 
+void
+Listener::set_callback(std::function<void(ipm::Receiver::Response)> callback,
+                       KeyedDispatcher::key_extractor_t key_extractor,
+                       size_t worker_count)
+{
+  std::lock_guard<InstrumentedMutex> lk(m_callback_mutex);
+  m_dispatcher.reset();
+  m_callback = callback;
+  if (callback != nullptr) {
+    m_dispatcher = std::make_unique<KeyedDispatcher>(callback,
+                                                     key_extractor,
+                                                     worker_count,
+                                                     m_connection_name,
+                                                     manager().get_connection_stats(m_connection_name));
+  }
+}
+
 void
 Listener::startup()
 {
   shutdown();
-  m_listener_thread.reset(new std::thread([&] { listener_thread_loop(); }));
+  {
+    std::lock_guard<std::mutex> lk(m_stop_mutex);
+    m_thread_running = true;
+  }
+  m_listener_thread.reset(new std::thread([&] {
+    listener_thread_loop();
+    {
+      std::lock_guard<std::mutex> lk(m_stop_mutex);
+      m_thread_running = false;
+    }
+    m_stop_cv.notify_all();
+  }));
 
   while (!m_is_listening.load()) {
     usleep(1000);
@@ -82,33 +134,103 @@ Listener::startup()
 void
 Listener::shutdown()
 {
-  m_is_listening = false;
+  request_stop();
+  join();
+}
+
+void
+Listener::request_stop() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lk(m_stop_mutex);
+    m_is_listening = false;
+  }
+  m_stop_cv.notify_all();
+}
+
+bool
+Listener::wait_stopped(std::chrono::steady_clock::time_point deadline)
+{
+  std::unique_lock<std::mutex> lk(m_stop_mutex);
+  return m_stop_cv.wait_until(lk, deadline, [&] { return !m_thread_running; });
+}
+
+void
+Listener::join()
+{
   if (m_listener_thread && m_listener_thread->joinable())
     m_listener_thread->join();
-  std::lock_guard<std::mutex> lk(m_callback_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_callback_mutex);
+  m_dispatcher.reset();
   m_callback = nullptr;
 }
 
+NetworkManager&
+Listener::manager() const
+{
+  return m_manager != nullptr ? *m_manager : NetworkManager::get();
+}
+
 void
 Listener::listener_thread_loop()
 {
+  auto& manager = this->manager();
+  auto stats = manager.get_connection_stats(m_connection_name);
+  auto activity = stats != nullptr ? &stats->listener_activity() : nullptr;
+  auto poll_timeout = activity != nullptr ? activity->poll_timeout : std::chrono::milliseconds(0);
+  auto busy_poll = activity != nullptr ? activity->busy_poll : std::chrono::microseconds(0);
+  // Without a poll timeout, a busy polling Listener backs off to waiting as long as others sleep
+  auto wait_timeout = poll_timeout.count() > 0 ? poll_timeout
+                      : busy_poll.count() > 0  ? s_idle_wait
+                                               : ipm::Receiver::s_no_block;
+
+  // Set while busy polling, from the end of the previous message's dispatch
+  std::chrono::steady_clock::time_point busy_poll_start;
+  bool busy_polling = false;
+
   bool first = true;
   do {
     try {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-      auto response = NetworkManager::get().receive_from(m_connection_name, ipm::Receiver::s_no_block);
+      auto response =
+        manager.receive_from(m_connection_name, busy_polling ? ipm::Receiver::s_no_block : wait_timeout);
 #pragma GCC diagnostic pop
 
+      auto received_time = std::chrono::steady_clock::now();
+      if (activity != nullptr) {
+        activity->last_receive_ns.store(ListenerActivity::to_ns(received_time), std::memory_order_relaxed);
+      }
+      if (busy_polling) {
+        activity->busy_poll_hits.fetch_add(1, std::memory_order_relaxed);
+        activity->busy_poll_ns.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(received_time - busy_poll_start).count(),
+          std::memory_order_relaxed);
+      }
+
       TLOG_DEBUG(25) << "Received " << response.data.size() << " bytes. Dispatching to callback.";
-      {
-        std::lock_guard<std::mutex> lk(m_callback_mutex);
-        if (m_callback != nullptr) {
-          m_callback(response);
-        }
+      dispatch(std::move(response), received_time, stats);
+
+      // The next message of a burst is likely to follow shortly, so look for it without sleeping
+      if (busy_poll.count() > 0) {
+        busy_poll_start = std::chrono::steady_clock::now();
+        busy_polling = true;
       }
     } catch (ipm::ReceiveTimeoutExpired const& tmo) {
-      usleep(10000);
+      if (busy_polling) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - busy_poll_start >= busy_poll) {
+          busy_polling = false;
+          activity->busy_poll_misses.fetch_add(1, std::memory_order_relaxed);
+          activity->busy_poll_ns.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - busy_poll_start).count(),
+            std::memory_order_relaxed);
+        }
+      } else if (wait_timeout.count() == 0) {
+        // Cut short by request_stop, so that stopping does not wait out the sleep
+        std::unique_lock<std::mutex> lk(m_stop_mutex);
+        m_stop_cv.wait_for(lk, s_idle_wait, [&] { return !first && !m_is_listening.load(); });
+      }
     }
 
     // All initialization complete
@@ -117,6 +239,67 @@ Listener::listener_thread_loop()
       first = false;
     }
   } while (m_is_listening.load());
+
+  m_drain_result = DrainResult();
+  if (m_drain_deadline.has_value()) {
+    drain(manager, stats);
+  }
+}
+
+void
+Listener::dispatch(ipm::Receiver::Response&& response,
+                   std::chrono::steady_clock::time_point received_time,
+                   ConnectionStats* stats)
+{
+  auto latency = stats != nullptr ? stats->latency() : nullptr;
+  auto activity = stats != nullptr ? &stats->listener_activity() : nullptr;
+
+  std::lock_guard<InstrumentedMutex> lk(m_callback_mutex);
+  if (m_dispatcher != nullptr) {
+    m_dispatcher->dispatch(std::move(response), received_time);
+  } else if (m_callback != nullptr) {
+    auto dispatch_time = std::chrono::steady_clock::now();
+    if (latency != nullptr) {
+      latency->dispatch_delay.record(dispatch_time - received_time);
+    }
+    if (activity != nullptr) {
+      activity->callback_start_ns.store(ListenerActivity::to_ns(dispatch_time), std::memory_order_relaxed);
+    }
+
+    m_callback(response);
+
+    auto callback_end = std::chrono::steady_clock::now();
+    if (latency != nullptr) {
+      latency->callback_time.record(callback_end - dispatch_time);
+    }
+    if (activity != nullptr) {
+      activity->callback_start_ns.store(0, std::memory_order_relaxed);
+      activity->check_callback_duration(m_connection_name, callback_end - dispatch_time, callback_end);
+    }
+  }
+}
+
+void
+Listener::drain(NetworkManager& manager, ConnectionStats* stats)
+{
+  auto deadline = *m_drain_deadline;
+  m_drain_result.timed_out = true;
+  while (std::chrono::steady_clock::now() < deadline) {
+    try {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      auto response = manager.receive_from(m_connection_name, ipm::Receiver::s_no_block);
+#pragma GCC diagnostic pop
+      dispatch(std::move(response), std::chrono::steady_clock::now(), stats);
+      ++m_drain_result.drained;
+    } catch (ipm::ReceiveTimeoutExpired const&) {
+      // The socket is empty
+      m_drain_result.timed_out = false;
+      break;
+    }
+  }
+  TLOG_DEBUG(5) << "Drained " << m_drain_result.drained << " messages on " << m_connection_name
+                << (m_drain_result.timed_out ? ", leaving the rest queued at the deadline" : "");
 }
 
 } // namespace dunedaq::networkmanager
\ No newline at end of file
@@ -0,0 +1,374 @@
+/**
+ *
+ * @file MemoryTransport.cpp In-process loopback implementation of the IPM interfaces
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/MemoryTransport.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::networkmanager {
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+const std::string s_memory_scheme = "mem://";
+
+// Blocking calls (ipm's s_block) wait for a year rather than until time_point::max(), which
+// condition variables do not handle reliably
+clock_type::time_point
+deadline_for(std::chrono::milliseconds timeout)
+{
+  return clock_type::now() + std::min<clock_type::duration>(timeout, std::chrono::hours(24 * 365));
+}
+} // namespace
+
+/**
+ * @brief Queue of messages waiting to be received, ordered by delivery time
+ */
+class MemoryQueue
+{
+public:
+  struct Message
+  {
+    clock_type::time_point deliver_time;
+    ipm::Receiver::Response response;
+  };
+
+  explicit MemoryQueue(size_t capacity)
+    : m_capacity(capacity)
+  {}
+
+  bool push(Message&& message, clock_type::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (!m_not_full.wait_until(lk, deadline, [&] { return m_messages.size() < m_capacity; })) {
+      return false;
+    }
+
+    // Messages from one channel arrive in delivery order; only a subscriber merging channels
+    // with different latencies needs to insert further up the queue
+    auto position = m_messages.end();
+    while (position != m_messages.begin() && std::prev(position)->deliver_time > message.deliver_time) {
+      --position;
+    }
+    m_messages.insert(position, std::move(message));
+    m_not_empty.notify_all();
+    return true;
+  }
+
+  bool pop(ipm::Receiver::Response& response, clock_type::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (true) {
+      auto now = clock_type::now();
+      if (!m_messages.empty() && m_messages.front().deliver_time <= now) {
+        break;
+      }
+      if (now >= deadline) {
+        return false;
+      }
+      auto wake_time = m_messages.empty() ? deadline : std::min(deadline, m_messages.front().deliver_time);
+      m_not_empty.wait_until(lk, wake_time);
+    }
+
+    response = std::move(m_messages.front().response);
+    m_messages.pop_front();
+    m_not_full.notify_one();
+    return true;
+  }
+
+  bool matches(std::string const& topic)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    for (auto& subscription : m_subscriptions) {
+      if (topic.compare(0, subscription.size(), subscription) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void subscribe(std::string const& topic)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_subscriptions.insert(topic);
+  }
+
+  void unsubscribe(std::string const& topic)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_subscriptions.erase(topic);
+  }
+
+private:
+  size_t m_capacity;
+  std::deque<Message> m_messages;
+  std::set<std::string> m_subscriptions;
+  std::mutex m_mutex;
+  std::condition_variable m_not_empty;
+  std::condition_variable m_not_full;
+};
+
+/**
+ * @brief A named link shared by all endpoints that open the same mem:// address.
+ *
+ * The channel exists while any endpoint uses it; messages still queued when the last endpoint
+ * closes are discarded, as with ZMQ inproc sockets.
+ */
+class MemoryChannel
+{
+public:
+  MemoryChannel(std::string const& name, MemoryLinkParameters const& parameters)
+    : m_name(name)
+    , m_parameters(parameters)
+    , m_random(parameters.seed ^ std::hash<std::string>()(name))
+    , m_queue(std::make_shared<MemoryQueue>(parameters.capacity))
+  {}
+
+  // A non-zero hwm, from the tuning in the plugin config, replaces the capacity given in the address
+  static std::shared_ptr<MemoryChannel> open(std::string const& address, size_t hwm)
+  {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::weak_ptr<MemoryChannel>> registry;
+
+    std::string name;
+    auto parameters = MemoryLinkParameters::parse(address, name);
+    if (hwm > 0) {
+      parameters.capacity = hwm;
+    }
+
+    std::lock_guard<std::mutex> lk(registry_mutex);
+    auto channel = registry[name].lock();
+    if (!channel) {
+      TLOG_DEBUG(12) << "Creating memory channel " << name;
+      channel = std::make_shared<MemoryChannel>(name, parameters);
+      registry[name] = channel;
+    }
+    return channel;
+  }
+
+  MemoryLinkParameters const& parameters() const { return m_parameters; }
+  std::shared_ptr<MemoryQueue> queue() const { return m_queue; }
+
+  void add_subscriber(std::shared_ptr<MemoryQueue> queue)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_subscribers.push_back(queue);
+  }
+
+  bool send(const void* message,
+            size_t size,
+            std::string const& metadata,
+            clock_type::time_point deadline,
+            bool publish)
+  {
+    MemoryQueue::Message queued;
+    std::vector<std::shared_ptr<MemoryQueue>> subscribers;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (m_parameters.drop_rate > 0. && (m_random() >> 11) * 0x1.0p-53 < m_parameters.drop_rate) {
+        return true;
+      }
+
+      // The link transmits one message at a time at the configured bandwidth
+      auto now = clock_type::now();
+      auto start = std::max(now, m_busy_until);
+      if (m_parameters.bandwidth_mbps > 0.) {
+        m_busy_until = start + std::chrono::duration_cast<clock_type::duration>(
+                                 std::chrono::duration<double, std::micro>(size * 8 / m_parameters.bandwidth_mbps));
+      } else {
+        m_busy_until = start;
+      }
+      queued.deliver_time = m_busy_until + m_parameters.latency;
+
+      if (publish) {
+        for (auto subscriber_it = m_subscribers.begin(); subscriber_it != m_subscribers.end();) {
+          auto subscriber = subscriber_it->lock();
+          if (!subscriber) {
+            subscriber_it = m_subscribers.erase(subscriber_it);
+            continue;
+          }
+          subscribers.push_back(subscriber);
+          ++subscriber_it;
+        }
+      }
+    }
+
+    queued.response.data.assign(static_cast<const char*>(message), static_cast<const char*>(message) + size);
+    queued.response.metadata = metadata;
+
+    if (!publish) {
+      return m_queue->push(std::move(queued), deadline);
+    }
+
+    // Like a ZMQ publisher, never block: subscribers that are full or not subscribed miss the message
+    for (auto& subscriber : subscribers) {
+      if (subscriber->matches(metadata)) {
+        auto copy = queued;
+        subscriber->push(std::move(copy), clock_type::now());
+      }
+    }
+    return true;
+  }
+
+private:
+  std::string m_name;
+  MemoryLinkParameters m_parameters;
+  std::mutex m_mutex;
+  clock_type::time_point m_busy_until;
+  std::mt19937_64 m_random;
+  std::shared_ptr<MemoryQueue> m_queue;
+  std::vector<std::weak_ptr<MemoryQueue>> m_subscribers;
+};
+
+MemoryLinkParameters
+MemoryLinkParameters::parse(std::string const& address, std::string& channel_name)
+{
+  if (!is_memory_address(address)) {
+    throw InvalidAddress(ERS_HERE, address, "memory addresses must start with " + s_memory_scheme);
+  }
+
+  MemoryLinkParameters parameters;
+  auto query_start = address.find('?');
+  channel_name = address.substr(s_memory_scheme.size(), query_start - s_memory_scheme.size());
+  if (channel_name.empty()) {
+    throw InvalidAddress(ERS_HERE, address, "no channel name given");
+  }
+  if (query_start == std::string::npos) {
+    return parameters;
+  }
+
+  std::istringstream query(address.substr(query_start + 1));
+  std::string item;
+  while (std::getline(query, item, '&')) {
+    auto separator = item.find('=');
+    if (separator == std::string::npos) {
+      throw InvalidAddress(ERS_HERE, address, "parameter " + item + " has no value");
+    }
+    auto key = item.substr(0, separator);
+    auto value = item.substr(separator + 1);
+    try {
+      if (key == "latency_us") {
+        parameters.latency = std::chrono::microseconds(std::stoll(value));
+      } else if (key == "bandwidth_mbps") {
+        parameters.bandwidth_mbps = std::stod(value);
+      } else if (key == "drop_rate") {
+        parameters.drop_rate = std::stod(value);
+      } else if (key == "seed") {
+        parameters.seed = std::stoull(value);
+      } else if (key == "capacity") {
+        parameters.capacity = std::max<size_t>(std::stoull(value), 1);
+      } else {
+        throw InvalidAddress(ERS_HERE, address, "unknown parameter " + key);
+      }
+    } catch (std::logic_error const&) {
+      throw InvalidAddress(ERS_HERE, address, "bad value for parameter " + key);
+    }
+  }
+  return parameters;
+}
+
+bool
+is_memory_address(std::string const& address)
+{
+  return address.compare(0, s_memory_scheme.size(), s_memory_scheme) == 0;
+}
+
+MemorySender::MemorySender(bool publisher)
+  : m_publisher(publisher)
+{}
+
+void
+MemorySender::connect_for_sends(const nlohmann::json& connection_info)
+{
+  m_channel = MemoryChannel::open(connection_info.value<std::string>("connection_string", ""),
+                                  connection_info.value<size_t>("hwm", 0));
+}
+
+void
+MemorySender::send_(const void* message, message_size_t N, const duration_t& timeout, std::string const& metadata)
+{
+  if (!m_channel->send(message, N, metadata, deadline_for(timeout), m_publisher)) {
+    throw ipm::SendTimeoutExpired(ERS_HERE, timeout.count());
+  }
+}
+
+void
+MemoryReceiver::connect_for_receives(const nlohmann::json& connection_info)
+{
+  m_channel = MemoryChannel::open(connection_info.value<std::string>("connection_string", ""),
+                                  connection_info.value<size_t>("hwm", 0));
+}
+
+ipm::Receiver::Response
+MemoryReceiver::receive_(const duration_t& timeout)
+{
+  Response response;
+  if (!m_channel->queue()->pop(response, deadline_for(timeout))) {
+    throw ipm::ReceiveTimeoutExpired(ERS_HERE, timeout.count());
+  }
+  return response;
+}
+
+void
+MemorySubscriber::connect_for_receives(const nlohmann::json& connection_info)
+{
+  std::vector<std::string> addresses;
+  if (connection_info.contains("connection_strings")) {
+    addresses = connection_info["connection_strings"].get<std::vector<std::string>>();
+  } else {
+    addresses.push_back(connection_info.value<std::string>("connection_string", ""));
+  }
+
+  auto hwm = connection_info.value<size_t>("hwm", 0);
+  for (auto& address : addresses) {
+    auto channel = MemoryChannel::open(address, hwm);
+    if (!m_queue) {
+      m_queue = std::make_shared<MemoryQueue>(hwm > 0 ? hwm : channel->parameters().capacity);
+    }
+    channel->add_subscriber(m_queue);
+    m_channels.push_back(channel);
+  }
+}
+
+void
+MemorySubscriber::subscribe(std::string const& topic)
+{
+  m_queue->subscribe(topic);
+}
+
+void
+MemorySubscriber::unsubscribe(std::string const& topic)
+{
+  m_queue->unsubscribe(topic);
+}
+
+ipm::Receiver::Response
+MemorySubscriber::receive_(const duration_t& timeout)
+{
+  Response response;
+  if (!m_queue->pop(response, deadline_for(timeout))) {
+    throw ipm::ReceiveTimeoutExpired(ERS_HERE, timeout.count());
+  }
+  return response;
+}
+
+} // namespace dunedaq::networkmanager
@@ -0,0 +1,226 @@
+/**
+ *
+ * @file MessageArena.cpp Pre-faulted, hugepage-backed memory for large message buffers
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/MessageArena.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace dunedaq::networkmanager {
+
+ArenaBuffer::ArenaBuffer(size_t size)
+  : m_heap_data(new char[size])
+  , m_data(m_heap_data.get())
+  , m_size(size)
+{}
+
+ArenaBuffer::ArenaBuffer(std::shared_ptr<MessageArena> arena, char* data, size_t size, size_t size_class)
+  : m_arena(std::move(arena))
+  , m_data(data)
+  , m_size(size)
+  , m_size_class(size_class)
+{}
+
+ArenaBuffer::~ArenaBuffer()
+{
+  release();
+}
+
+ArenaBuffer::ArenaBuffer(ArenaBuffer&& other) noexcept
+  : m_arena(std::move(other.m_arena))
+  , m_heap_data(std::move(other.m_heap_data))
+  , m_data(std::exchange(other.m_data, nullptr))
+  , m_size(std::exchange(other.m_size, 0))
+  , m_size_class(other.m_size_class)
+{}
+
+ArenaBuffer&
+ArenaBuffer::operator=(ArenaBuffer&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    m_arena = std::move(other.m_arena);
+    m_heap_data = std::move(other.m_heap_data);
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_size_class = other.m_size_class;
+  }
+  return *this;
+}
+
+void
+ArenaBuffer::release()
+{
+  if (m_arena != nullptr && m_data != nullptr) {
+    m_arena->release(m_data, m_size_class);
+  }
+  m_arena.reset();
+  m_heap_data.reset();
+  m_data = nullptr;
+  m_size = 0;
+}
+
+std::shared_ptr<MessageArena>
+MessageArena::create(size_t size, bool huge_pages, bool prefault)
+{
+  // Whole hugepages, so that the region can be backed by them
+  auto capacity = (size + s_huge_page_size - 1) / s_huge_page_size * s_huge_page_size;
+
+  void* region = MAP_FAILED;
+  bool explicit_huge_pages = false;
+  if (huge_pages) {
+    region = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    explicit_huge_pages = region != MAP_FAILED;
+  }
+  if (region == MAP_FAILED) {
+    region = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+      throw ArenaCreationFailed(ERS_HERE, capacity, std::strerror(errno));
+    }
+    if (huge_pages) {
+      // Transparent hugepages are best effort: the arena still works with normal pages
+      madvise(region, capacity, MADV_HUGEPAGE);
+    }
+  }
+
+  if (prefault) {
+    auto bytes = static_cast<volatile char*>(region);
+    for (size_t offset = 0; offset < capacity; offset += s_min_block_size) {
+      bytes[offset] = 0;
+    }
+  }
+
+  TLOG_DEBUG(16) << "Created message arena of " << capacity << " bytes"
+                 << (explicit_huge_pages ? " backed by explicit hugepages" : "");
+  return std::shared_ptr<MessageArena>(new MessageArena(static_cast<char*>(region), capacity, explicit_huge_pages));
+}
+
+MessageArena::MessageArena(char* region, size_t capacity, bool explicit_huge_pages)
+  : m_region(region)
+  , m_capacity(capacity)
+  , m_explicit_huge_pages(explicit_huge_pages)
+  , m_free(size_class(capacity) + 1)
+{
+  // The capacity, a multiple of the hugepage size, is split into power-of-two blocks from the largest down,
+  // so that each is aligned to its size
+  size_t offset = 0;
+  for (auto size_class = m_free.size(); size_class-- > 0;) {
+    auto block_size = s_min_block_size << size_class;
+    if (m_capacity - offset >= block_size) {
+      m_free[size_class].insert(m_region + offset);
+      offset += block_size;
+    }
+  }
+}
+
+MessageArena::~MessageArena()
+{
+  munmap(m_region, m_capacity);
+}
+
+size_t
+MessageArena::size_class(size_t size)
+{
+  size_t size_class = 0;
+  while ((s_min_block_size << size_class) < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+ArenaBuffer
+MessageArena::allocate(size_t size)
+{
+  auto size_class = MessageArena::size_class(size);
+  auto block_size = s_min_block_size << size_class;
+
+  char* block = nullptr;
+  if (size_class < m_free.size()) {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    auto split_class = size_class;
+    while (split_class < m_free.size() && m_free[split_class].empty()) {
+      ++split_class;
+    }
+    if (split_class < m_free.size()) {
+      // The lowest free block, so that the upper part of the region stays free for large buffers
+      block = *m_free[split_class].begin();
+      m_free[split_class].erase(m_free[split_class].begin());
+      while (split_class > size_class) {
+        --split_class;
+        m_free[split_class].insert(block + (s_min_block_size << split_class));
+      }
+    }
+  }
+
+  if (block == nullptr) {
+    m_fallback_allocations.fetch_add(1, std::memory_order_relaxed);
+    return ArenaBuffer(size);
+  }
+
+  m_allocations.fetch_add(1, std::memory_order_relaxed);
+  auto used = m_used_bytes.fetch_add(block_size, std::memory_order_relaxed) + block_size;
+  auto peak = m_peak_used_bytes.load(std::memory_order_relaxed);
+  while (used > peak && !m_peak_used_bytes.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+  }
+  return ArenaBuffer(shared_from_this(), block, size, size_class);
+}
+
+void
+MessageArena::release(char* data, size_t size_class)
+{
+  m_used_bytes.fetch_sub(s_min_block_size << size_class, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto offset = static_cast<size_t>(data - m_region);
+  auto max_class = max_size_class(offset);
+  while (size_class < max_class) {
+    auto buddy = m_free[size_class].find(m_region + (offset ^ (s_min_block_size << size_class)));
+    if (buddy == m_free[size_class].end()) {
+      break;
+    }
+    m_free[size_class].erase(buddy);
+    offset &= ~(s_min_block_size << size_class);
+    ++size_class;
+  }
+  m_free[size_class].insert(m_region + offset);
+}
+
+size_t
+MessageArena::max_size_class(size_t offset) const
+{
+  size_t block_offset = 0;
+  for (auto size_class = m_free.size(); size_class-- > 0;) {
+    auto block_size = s_min_block_size << size_class;
+    if (m_capacity - block_offset >= block_size) {
+      if (offset < block_offset + block_size) {
+        return size_class;
+      }
+      block_offset += block_size;
+    }
+  }
+  return 0;
+}
+
+void
+MessageArena::fill_info(connectioninfo::ArenaInfo& info) const
+{
+  info.capacity_bytes = m_capacity;
+  info.used_bytes = m_used_bytes.load(std::memory_order_relaxed);
+  info.peak_used_bytes = m_peak_used_bytes.load(std::memory_order_relaxed);
+  info.allocations = m_allocations.load(std::memory_order_relaxed);
+  info.fallback_allocations = m_fallback_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace dunedaq::networkmanager
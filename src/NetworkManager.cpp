@@ -8,45 +8,423 @@
 
 #include "networkmanager/NetworkManager.hpp"
 
+#include "networkmanager/MemoryTransport.hpp"
+#include "networkmanager/StripedTransport.hpp"
 #include "networkmanager/connectioninfo/InfoNljs.hpp"
 
 #include "ipm/PluginInfo.hpp"
 #include "logging/Logging.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace dunedaq::networkmanager {
 
+namespace {
+/**
+ * @brief Per-thread buffer in which a message is put together with its header before being sent.
+ *
+ * IPM senders take a single contiguous buffer, so the header cannot be sent separately. The memory
+ * is kept for the next message on the thread, unless it has grown beyond s_max_kept_size for an
+ * unusually large one, in which case it is released once that has been sent (or has failed).
+ */
+class StagingBuffer
+{
+public:
+  static constexpr size_t s_max_kept_size = 1024 * 1024;
+
+  StagingBuffer(std::vector<char>& buffer, size_t size)
+    : m_buffer(buffer)
+  {
+    m_buffer.resize(size);
+  }
+  ~StagingBuffer()
+  {
+    if (m_buffer.capacity() > s_max_kept_size) {
+      std::vector<char>().swap(m_buffer);
+    }
+  }
+
+  StagingBuffer(StagingBuffer const&) = delete;
+  StagingBuffer(StagingBuffer&&) = delete;
+  StagingBuffer& operator=(StagingBuffer const&) = delete;
+  StagingBuffer& operator=(StagingBuffer&&) = delete;
+
+  char* data() { return m_buffer.data(); }
+  size_t size() const { return m_buffer.size(); }
+
+private:
+  std::vector<char>& m_buffer;
+};
+
+void
+add_latency_info(opmonlib::InfoCollector& ci, std::string const& name, LatencyHistogram& histogram)
+{
+  connectioninfo::LatencyInfo info;
+  histogram.fill_info(info);
+  if (info.samples == 0) {
+    return;
+  }
+
+  opmonlib::InfoCollector tmp_ic;
+  tmp_ic.add(info);
+  ci.add(name, tmp_ic);
+}
+
+/**
+ * @brief Per-thread map from connection name to an open plugin's entry in a NetworkManager's plugin map.
+ *
+ * Map entries are never erased while a NetworkManager is configured, so the cached pointers stay
+ * valid until reset(), which advances NetworkManager::s_plugin_epoch and so empties every cache.
+ */
+template<typename Plugin>
+struct PluginCache
+{
+  uint64_t epoch{ 0 };
+  std::unordered_map<const NetworkManager*, std::unordered_map<std::string, std::shared_ptr<Plugin> const*>> entries;
+
+  std::shared_ptr<Plugin> const* find(const NetworkManager* manager, std::string const& name, uint64_t current_epoch)
+  {
+    if (epoch != current_epoch) {
+      entries.clear();
+      epoch = current_epoch;
+      return nullptr;
+    }
+    auto manager_it = entries.find(manager);
+    if (manager_it == entries.end()) {
+      return nullptr;
+    }
+    auto entry_it = manager_it->second.find(name);
+    return entry_it != manager_it->second.end() ? entry_it->second : nullptr;
+  }
+};
+
+// Report a callback which is still running past its budget, once per callback invocation, since a
+// stalled Listener cannot report it itself
+void
+check_for_stalled_callback(std::string const& name, ListenerActivity& activity)
+{
+  auto callback_start_ns = activity.callback_start_ns.load(std::memory_order_relaxed);
+  if (activity.callback_budget.count() == 0 || callback_start_ns == 0) {
+    return;
+  }
+
+  auto running = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::nanoseconds(callback_start_ns);
+  if (running > activity.callback_budget &&
+      activity.reported_stall_ns.exchange(callback_start_ns, std::memory_order_relaxed) != callback_start_ns) {
+    ers::warning(CallbackOverrun(ERS_HERE,
+                                 name,
+                                 std::chrono::duration<double, std::milli>(running).count(),
+                                 std::chrono::duration<double, std::milli>(activity.callback_budget).count(),
+                                 activity.callback_overruns.load(std::memory_order_relaxed)));
+  }
+}
+
+void
+add_lock_info(opmonlib::InfoCollector& ci, std::string const& name, connectioninfo::LockInfo const& info)
+{
+  if (info.acquisitions == 0) {
+    return;
+  }
+
+  opmonlib::InfoCollector tmp_ic;
+  tmp_ic.add(info);
+  ci.add(name, tmp_ic);
+}
+
+std::shared_ptr<ipm::Receiver>
+make_receiver_plugin(std::string const& address, bool is_subscriber)
+{
+  if (is_memory_address(address)) {
+    if (is_subscriber) {
+      return std::make_shared<MemorySubscriber>();
+    }
+    return std::make_shared<MemoryReceiver>();
+  }
+
+  auto plugin_type =
+    ipm::get_recommended_plugin_name(is_subscriber ? ipm::IpmPluginType::Subscriber : ipm::IpmPluginType::Receiver);
+  TLOG_DEBUG(12) << "Creating receiver plugin of type " << plugin_type << " for " << address;
+  return dunedaq::ipm::make_ipm_receiver(plugin_type);
+}
+
+std::shared_ptr<ipm::Sender>
+make_sender_plugin(std::string const& address, bool is_publisher)
+{
+  if (is_memory_address(address)) {
+    return std::make_shared<MemorySender>(is_publisher);
+  }
+
+  auto plugin_type =
+    ipm::get_recommended_plugin_name(is_publisher ? ipm::IpmPluginType::Publisher : ipm::IpmPluginType::Sender);
+  TLOG_DEBUG(11) << "Creating sender plugin of type " << plugin_type << " for " << address;
+  return dunedaq::ipm::make_ipm_sender(plugin_type);
+}
+
+// Release the last references to plugins on up to thread_count threads, since closing a socket may block for its
+// linger period. Returns the number of plugins not closed by the deadline, which their threads, added to threads
+// for the caller to join, go on closing.
+size_t
+close_plugins(std::vector<std::shared_ptr<void>> plugins,
+              size_t thread_count,
+              std::chrono::steady_clock::time_point deadline,
+              std::vector<std::thread>& threads)
+{
+  struct Teardown
+  {
+    std::mutex mutex;
+    std::condition_variable closed_cv;
+    std::vector<std::shared_ptr<void>> plugins;
+    size_t next{ 0 };
+    size_t closed{ 0 };
+  };
+
+  auto teardown = std::make_shared<Teardown>();
+  teardown->plugins = std::move(plugins);
+  auto total = teardown->plugins.size();
+  if (total <= 1) {
+    teardown->plugins.clear();
+    return 0;
+  }
+
+  std::vector<std::thread> close_threads;
+  for (size_t idx = 0; idx < std::min(thread_count, total); ++idx) {
+    close_threads.emplace_back([teardown] {
+      std::unique_lock<std::mutex> lk(teardown->mutex);
+      while (teardown->next < teardown->plugins.size()) {
+        auto plugin = std::move(teardown->plugins[teardown->next++]);
+        lk.unlock();
+        plugin.reset();
+        lk.lock();
+        ++teardown->closed;
+        teardown->closed_cv.notify_all();
+      }
+    });
+  }
+
+  size_t unclosed = 0;
+  {
+    std::unique_lock<std::mutex> lk(teardown->mutex);
+    teardown->closed_cv.wait_until(lk, deadline, [&] { return teardown->closed == total; });
+    unclosed = total - teardown->closed;
+  }
+  if (unclosed == 0) {
+    for (auto& thread : close_threads) {
+      thread.join();
+    }
+  } else {
+    std::move(close_threads.begin(), close_threads.end(), std::back_inserter(threads));
+  }
+  return unclosed;
+}
+
+// Plugin config keys for the tuning options that do not keep the plugin default
+nlohmann::json
+tuning_config(nwmgr::Tuning const& tuning)
+{
+  nlohmann::json config = nlohmann::json::object();
+  if (tuning.hwm > 0) {
+    config["hwm"] = tuning.hwm;
+  }
+  if (tuning.send_buffer_bytes > 0) {
+    config["send_buffer_bytes"] = tuning.send_buffer_bytes;
+  }
+  if (tuning.receive_buffer_bytes > 0) {
+    config["receive_buffer_bytes"] = tuning.receive_buffer_bytes;
+  }
+  if (tuning.linger_ms >= 0) {
+    config["linger_ms"] = tuning.linger_ms;
+  }
+  if (tuning.io_threads > 0) {
+    config["io_threads"] = tuning.io_threads;
+  }
+  return config;
+}
+} // namespace
+
 std::unique_ptr<NetworkManager> NetworkManager::s_instance = nullptr;
+std::once_flag NetworkManager::s_instance_flag;
+std::atomic<uint64_t> NetworkManager::s_plugin_epoch{ 1 };
+
+NetworkManager::~NetworkManager()
+{
+  reset();
+  join_teardown_threads();
+}
+
+uint64_t
+NetworkManager::generate_sender_id()
+{
+  std::random_device rd;
+  return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
 
 NetworkManager&
 NetworkManager::get()
 {
-  if (!s_instance) {
-    s_instance.reset(new NetworkManager());
-  }
+  std::call_once(s_instance_flag, []() { s_instance = std::make_unique<NetworkManager>(); });
   return *s_instance;
 }
 
 void
 NetworkManager::gather_stats(opmonlib::InfoCollector& ci, int level)
 {
+  // Lock statistics are collected first, since m_registration_mutex may not be taken under m_stats_mutex
+  std::unordered_map<std::string, connectioninfo::LockInfo> connection_locks;
+  std::unordered_map<std::string, connectioninfo::LockInfo> callback_locks;
+  // Recording follows the level of each call, so that it stops again once detailed reports are no longer requested
+  bool lock_stats_were_enabled = InstrumentedMutex::is_enabled();
+  InstrumentedMutex::set_enabled(level >= s_lock_stats_level);
+  if (level >= s_lock_stats_level) {
+    gather_lock_stats(ci, connection_locks, callback_locks);
+  } else if (lock_stats_were_enabled) {
+    // Discard what was recorded since the previous report, which would otherwise end up in the next one
+    opmonlib::InfoCollector discarded_ci;
+    std::unordered_map<std::string, connectioninfo::LockInfo> discarded_locks;
+    gather_lock_stats(discarded_ci, discarded_locks, discarded_locks);
+  }
 
-  for( auto & sender : m_sender_plugins ) {
-    opmonlib::InfoCollector tmp_ic;
-    sender.second -> get_info( tmp_ic, level );
-    ci.add( sender.first, tmp_ic );
+  std::lock_guard<std::mutex> lk(m_stats_mutex);
+  if (m_arena != nullptr) {
+    connectioninfo::ArenaInfo arena_info;
+    m_arena->fill_info(arena_info);
+    opmonlib::InfoCollector arena_ic;
+    arena_ic.add(arena_info);
+    ci.add(s_arena_stats_name, arena_ic);
   }
 
-  for( auto & receiver : m_receiver_plugins ) {
+  // Pattern subscriptions are reported like topics; they are only removed by reset, under m_stats_mutex
+  std::vector<std::pair<std::string const*, ConnectionStats*>> all_stats;
+  for (auto& stats_pair : m_connection_stats) {
+    all_stats.emplace_back(&stats_pair.first, stats_pair.second.get());
+  }
+  {
+    std::lock_guard<std::mutex> pattern_lk(m_pattern_mutex);
+    for (auto& subscription_pair : m_pattern_subscriptions) {
+      all_stats.emplace_back(&subscription_pair.first, subscription_pair.second.stats.get());
+    }
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  connectioninfo::Info totals;
+  for (auto& stats_pair : all_stats) {
+    check_for_stalled_callback(*stats_pair.first, stats_pair.second->listener_activity());
+    stats_pair.second->add_to_totals(totals);
+    // Histograms are only allocated, and therefore only recorded, while detailed reports are being requested
+    if (level >= s_latency_stats_level) {
+      stats_pair.second->enable_latency_histograms();
+    } else {
+      stats_pair.second->disable_latency_histograms();
+    }
+  }
+  if (!m_connection_stats.empty()) {
+    ConnectionStats::fill_rates(totals, m_last_totals, std::chrono::duration<double>(now - m_last_totals_time).count());
+    m_last_totals = totals;
+    m_last_totals_time = now;
+    opmonlib::InfoCollector totals_ic;
+    totals_ic.add(totals);
+    ci.add(s_totals_stats_name, totals_ic);
+  }
+
+  if (level < s_connection_stats_level) {
+    return;
+  }
+
+  for (auto& stats_pair : all_stats) {
+    auto latency = stats_pair.second->latency();
+
+    // Connections without news since the previous report are left out, saving the opmon thread the work
+    auto tracker_it = m_request_trackers.find(*stats_pair.first);
+    if (!stats_pair.second->changed_since_last_info(now) && tracker_it == m_request_trackers.end()) {
+      continue;
+    }
+
+    connectioninfo::Info info;
+    stats_pair.second->fill_info(info);
     opmonlib::InfoCollector tmp_ic;
-    receiver.second -> get_info( tmp_ic, level );
-    ci.add( receiver.first, tmp_ic );
+    tmp_ic.add(info);
+
+    if (latency != nullptr) {
+      add_latency_info(tmp_ic, "send_time", latency->send_time);
+      add_latency_info(tmp_ic, "lock_wait", latency->lock_wait);
+      add_latency_info(tmp_ic, "dispatch_delay", latency->dispatch_delay);
+      add_latency_info(tmp_ic, "callback_time", latency->callback_time);
+    }
+    if (stats_pair.second->envelope() != nullptr) {
+      add_latency_info(tmp_ic, "one_way_latency", stats_pair.second->envelope()->one_way_latency);
+    }
+    if (connection_locks.count(*stats_pair.first)) {
+      add_lock_info(tmp_ic, "connection_lock", connection_locks[*stats_pair.first]);
+    }
+    if (callback_locks.count(*stats_pair.first)) {
+      add_lock_info(tmp_ic, "callback_lock", callback_locks[*stats_pair.first]);
+    }
+    if (tracker_it != m_request_trackers.end()) {
+      connectioninfo::RequestInfo request_info;
+      tracker_it->second->fill_info(request_info);
+      opmonlib::InfoCollector request_ic;
+      request_ic.add(request_info);
+      tmp_ic.add("requests", request_ic);
+    }
+
+    ci.add(*stats_pair.first, tmp_ic);
   }
-  
+}
+
+void
+NetworkManager::gather_lock_stats(opmonlib::InfoCollector& ci,
+                                  std::unordered_map<std::string, connectioninfo::LockInfo>& connection_locks,
+                                  std::unordered_map<std::string, connectioninfo::LockInfo>& callback_locks)
+{
+  opmonlib::InfoCollector locks_ic;
+  const std::vector<std::pair<std::string, InstrumentedMutex*>> global_locks{
+    { "registration", &m_registration_mutex },
+    { "sender_plugin_map", &m_sender_plugin_map_mutex },
+    { "receiver_plugin_map", &m_receiver_plugin_map_mutex },
+    { "connection_map", &m_connection_map_mutex }
+  };
+  for (auto& lock_pair : global_locks) {
+    connectioninfo::LockInfo info;
+    lock_pair.second->fill_info(info);
+    add_lock_info(locks_ic, lock_pair.first, info);
+  }
+  if (!locks_ic.is_empty()) {
+    ci.add(s_lock_stats_name, locks_ic);
+  }
+
+  {
+    std::lock_guard<InstrumentedMutex> lk(m_connection_map_mutex);
+    for (auto& mutex_pair : m_connection_mutexes) {
+      mutex_pair.second.fill_info(connection_locks[mutex_pair.first]);
+    }
+  }
+
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+  for (auto& listener_pair : m_registered_listeners) {
+    listener_pair.second->fill_lock_info(callback_locks[listener_pair.first]);
+  }
+}
+
+void
+NetworkManager::join_teardown_threads()
+{
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+  for (auto& thread : m_teardown_threads) {
+    thread.join();
+  }
+  m_teardown_threads.clear();
 }
 
 void
@@ -55,6 +433,9 @@ NetworkManager::configure(const nwmgr::Connections& connections)
   if (!m_connection_map.empty()) {
     throw NetworkManagerAlreadyConfigured(ERS_HERE);
   }
+  // The plugins a previous reset() left closing may still hold the addresses about to be reused
+  join_teardown_threads();
+  m_sender_id = generate_sender_id();
 
   for (auto& connection : connections) {
     TLOG_DEBUG(15) << "Adding connection " << connection.name << " to connection map";
@@ -79,34 +460,241 @@ NetworkManager::configure(const nwmgr::Connections& connections)
       }
     }
   }
+
+  for (auto& topic_pair : m_topic_map) {
+    for (auto& connection_name : topic_pair.second) {
+      if (m_connection_map[connection_name].envelope != m_connection_map[topic_pair.second[0]].envelope) {
+        reset();
+        throw EnvelopeMismatch(ERS_HERE, topic_pair.first);
+      }
+    }
+  }
+
+  for (auto& connection_pair : m_connection_map) {
+    if (connection_pair.second.chunk_size > 0 && !connection_pair.second.envelope) {
+      reset();
+      throw EnvelopeRequired(ERS_HERE, connection_pair.first, "chunking");
+    }
+  }
+
+  for (auto& connection_pair : m_connection_map) {
+    auto& connection = connection_pair.second;
+    if (connection.stripe_addresses.empty()) {
+      continue;
+    }
+    std::string reason;
+    if (!connection.alternate_addresses.empty()) {
+      reason = "stripes cannot have alternate addresses";
+    } else if (connection.stripe_ordered && !connection.envelope) {
+      reason = "ordered stripes need envelopes";
+    } else if (connection.stripe_ordered && !connection.topics.empty()) {
+      reason = "only point-to-point connections can have ordered stripes";
+    }
+    if (!reason.empty()) {
+      reset();
+      throw InvalidStriping(ERS_HERE, connection_pair.first, reason);
+    }
+  }
+
+  for (auto& connection_pair : m_connection_map) {
+    auto& reply_connection = connection_pair.second.reply_connection;
+    if (!reply_connection.empty() && !m_connection_map.count(reply_connection)) {
+      reset();
+      throw ConnectionNotFound(ERS_HERE, reply_connection);
+    }
+  }
+
+  for (auto& connection_pair : m_connection_map) {
+    auto& resolution = m_resolutions[connection_pair.first];
+    resolution.kind =
+      connection_pair.second.topics.empty() ? Resolution::Kind::Connection : Resolution::Kind::PubSubConnection;
+    resolution.addresses = { connection_pair.second.address };
+    resolution.addresses.insert(resolution.addresses.end(),
+                                connection_pair.second.stripe_addresses.begin(),
+                                connection_pair.second.stripe_addresses.end());
+    resolution.subscriptions = connection_pair.second.topics;
+    resolution.tuning = tuning_config(connection_pair.second.tuning);
+  }
+  for (auto& topic_pair : m_topic_map) {
+    auto& resolution = m_resolutions[topic_pair.first];
+    resolution = resolve_topic(topic_pair.second);
+    resolution.subscriptions = { topic_pair.first };
+    m_topic_trie.insert(topic_pair.first);
+  }
+
+  std::lock_guard<std::mutex> lk(m_stats_mutex);
+  for (auto& connection_pair : m_connection_map) {
+    if (!connection_pair.second.reply_connection.empty()) {
+      m_request_trackers[connection_pair.first] = std::make_unique<RequestTracker>(connection_pair.first);
+    }
+    auto& stats = m_connection_stats[connection_pair.first];
+    stats = std::make_unique<ConnectionStats>();
+    if (connection_pair.second.envelope) {
+      stats->enable_envelope();
+      stats->envelope()->reassembler.set_max_message_size(connection_pair.second.chunk_size *
+                                                          Reassembler::s_max_chunks);
+    }
+    stats->listener_activity().callback_budget = std::chrono::milliseconds(connection_pair.second.callback_budget_ms);
+    stats->listener_activity().poll_timeout = std::chrono::milliseconds(connection_pair.second.tuning.poll_timeout_ms);
+    stats->listener_activity().busy_poll = std::chrono::microseconds(connection_pair.second.tuning.busy_poll_us);
+  }
+  for (auto& topic_pair : m_topic_map) {
+    m_connection_stats[topic_pair.first] = make_topic_stats(topic_pair.second);
+  }
+}
+
+NetworkManager::Resolution
+NetworkManager::resolve_topic(std::vector<std::string> const& connection_names) const
+{
+  Resolution resolution;
+  resolution.kind = Resolution::Kind::Topic;
+  resolution.connections = connection_names;
+  // A topic's subscriber serves all the connections declaring it, so it gets the largest queues and
+  // buffers that any of them asks for
+  nwmgr::Tuning tuning;
+  for (auto& connection_name : connection_names) {
+    auto& connection = m_connection_map.at(connection_name);
+    resolution.addresses.push_back(connection.address);
+    resolution.addresses.insert(
+      resolution.addresses.end(), connection.stripe_addresses.begin(), connection.stripe_addresses.end());
+    tuning.hwm = std::max(tuning.hwm, connection.tuning.hwm);
+    tuning.send_buffer_bytes = std::max(tuning.send_buffer_bytes, connection.tuning.send_buffer_bytes);
+    tuning.receive_buffer_bytes = std::max(tuning.receive_buffer_bytes, connection.tuning.receive_buffer_bytes);
+    tuning.linger_ms = std::max(tuning.linger_ms, connection.tuning.linger_ms);
+    tuning.io_threads = std::max(tuning.io_threads, connection.tuning.io_threads);
+  }
+  resolution.tuning = tuning_config(tuning);
+  return resolution;
+}
+
+std::unique_ptr<ConnectionStats>
+NetworkManager::make_topic_stats(std::vector<std::string> const& connection_names) const
+{
+  auto stats = std::make_unique<ConnectionStats>();
+  if (m_connection_map.at(connection_names[0]).envelope) {
+    stats->enable_envelope();
+    uint64_t chunk_size = 0;
+    for (auto& connection_name : connection_names) {
+      chunk_size = std::max<uint64_t>(chunk_size, m_connection_map.at(connection_name).chunk_size);
+    }
+    stats->envelope()->reassembler.set_max_message_size(chunk_size * Reassembler::s_max_chunks);
+  }
+
+  // A topic's callback has to keep up with the tightest budget of the connections declaring it, and its
+  // Listener polls as often, and busy polls as long, as the most demanding of them
+  auto& budget = stats->listener_activity().callback_budget;
+  auto& poll_timeout = stats->listener_activity().poll_timeout;
+  auto& busy_poll = stats->listener_activity().busy_poll;
+  for (auto& connection_name : connection_names) {
+    auto& connection = m_connection_map.at(connection_name);
+    std::chrono::milliseconds connection_budget(connection.callback_budget_ms);
+    if (connection_budget.count() > 0 && (budget.count() == 0 || connection_budget < budget)) {
+      budget = connection_budget;
+    }
+    std::chrono::milliseconds connection_poll_timeout(connection.tuning.poll_timeout_ms);
+    if (connection_poll_timeout.count() > 0 && (poll_timeout.count() == 0 || connection_poll_timeout < poll_timeout)) {
+      poll_timeout = connection_poll_timeout;
+    }
+    busy_poll = std::max(busy_poll, std::chrono::microseconds(connection.tuning.busy_poll_us));
+  }
+  return stats;
 }
 
 void
 NetworkManager::reset()
 {
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
+  std::unique_lock<InstrumentedMutex> lk(m_registration_mutex);
+  // Draining Listeners use the plugins and statistics about to be released
+  m_drained_cv.wait(lk, [&] { return m_draining_listeners.empty(); });
+  auto deadline = std::chrono::steady_clock::now() + s_teardown_timeout;
+  m_reconnector.clear();
+
+  // Listeners are all told to stop first, so that their last receives and idle waits run out together
+  for (auto& listener_pair : m_registered_listeners) {
+    listener_pair.second->request_stop();
+  }
+  std::vector<std::string> running_listeners;
+  for (auto& listener_pair : m_registered_listeners) {
+    if (!listener_pair.second->wait_stopped(deadline)) {
+      running_listeners.push_back(listener_pair.first);
+    }
+  }
+  if (!running_listeners.empty()) {
+    ers::warning(TeardownIncomplete(ERS_HERE,
+                                    s_teardown_timeout.count(),
+                                    std::to_string(running_listeners.size()) + " Listeners, including " +
+                                      running_listeners[0]));
+  }
   for (auto& listener_pair : m_registered_listeners) {
-    listener_pair.second.shutdown();
+    listener_pair.second->join();
   }
   m_registered_listeners.clear();
+
+  std::vector<std::shared_ptr<void>> plugins;
   {
-    std::lock_guard<std::mutex> lk(m_sender_plugin_map_mutex);
+    std::lock_guard<InstrumentedMutex> lk(m_sender_plugin_map_mutex);
+    for (auto& plugin_pair : m_sender_plugins) {
+      plugins.push_back(std::move(plugin_pair.second));
+    }
     m_sender_plugins.clear();
   }
   {
-    std::lock_guard<std::mutex> lk(m_receiver_plugin_map_mutex);
+    std::lock_guard<InstrumentedMutex> lk(m_receiver_plugin_map_mutex);
+    for (auto& plugin_pair : m_receiver_plugins) {
+      plugins.push_back(std::move(plugin_pair.second));
+    }
     m_receiver_plugins.clear();
   }
+  s_plugin_epoch.fetch_add(1, std::memory_order_acq_rel);
+  auto unclosed_plugins = close_plugins(std::move(plugins), s_teardown_threads, deadline, m_teardown_threads);
+  if (unclosed_plugins > 0) {
+    ers::warning(
+      TeardownIncomplete(ERS_HERE, s_teardown_timeout.count(), std::to_string(unclosed_plugins) + " plugins to close"));
+  }
+  {
+    std::lock_guard<std::mutex> lk(m_stats_mutex);
+    m_connection_stats.clear();
+    // The reply listeners are gone, so this fails the requests still waiting with RequestCancelled
+    m_request_trackers.clear();
+    m_arena.reset();
+    m_last_totals = connectioninfo::Info();
+    m_last_totals_time = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> pattern_lk(m_pattern_mutex);
+    m_pattern_subscriptions.clear();
+  }
+  m_topic_trie.clear();
+  m_resolutions.clear();
   m_topic_map.clear();
   m_connection_map.clear();
-  m_connection_mutexes.clear();
+  {
+    std::lock_guard<InstrumentedMutex> lk(m_connection_map_mutex);
+    m_connection_mutexes.clear();
+  }
+}
+
+void
+NetworkManager::configure_arena(const nwmgr::Arena& conf)
+{
+  auto arena = conf.size > 0 ? MessageArena::create(conf.size, conf.huge_pages, conf.prefault) : nullptr;
+  std::lock_guard<std::mutex> lk(m_stats_mutex);
+  m_arena = arena;
+}
+
+ArenaBuffer
+NetworkManager::allocate_buffer(size_t size)
+{
+  if (m_arena != nullptr) {
+    return m_arena->allocate(size);
+  }
+  return ArenaBuffer(size);
 }
 
 void
 NetworkManager::start_listening(std::string const& connection_name)
 {
   TLOG_DEBUG(5) << "Start listening on connection " << connection_name;
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
+  std::unique_lock<InstrumentedMutex> lk(m_registration_mutex);
+  wait_for_drain(lk, connection_name);
   if (!m_connection_map.count(connection_name)) {
     throw ConnectionNotFound(ERS_HERE, connection_name);
   }
@@ -115,19 +703,48 @@ NetworkManager::start_listening(std::string const& connection_name)
     throw ListenerAlreadyRegistered(ERS_HERE, connection_name);
   }
 
-  m_registered_listeners[connection_name].start_listening(connection_name);
+  start_listener(connection_name);
 }
 
 void
 NetworkManager::stop_listening(std::string const& connection_name)
 {
   TLOG_DEBUG(5) << "Stop listening on connection " << connection_name;
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
   if (!is_listening_locked(connection_name)) {
     throw ListenerNotRegistered(ERS_HERE, connection_name);
   }
 
-  m_registered_listeners[connection_name].stop_listening();
+  m_registered_listeners[connection_name]->stop_listening();
+}
+
+Listener::DrainResult
+NetworkManager::stop_listening(std::string const& connection_name, std::chrono::milliseconds drain_timeout)
+{
+  TLOG_DEBUG(5) << "Stop listening on connection " << connection_name << " after draining for up to "
+                << drain_timeout.count() << " ms";
+  Listener* listener = nullptr;
+  {
+    std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+    if (!is_listening_locked(connection_name)) {
+      throw ListenerNotRegistered(ERS_HERE, connection_name);
+    }
+    listener = m_registered_listeners[connection_name].get();
+    m_draining_listeners.insert(connection_name);
+  }
+
+  // Drained without the registration lock, which callbacks may need, e.g. to send requests. The Listener stays
+  // registered, as no longer listening, so that it is neither restarted nor destroyed by reset() meanwhile.
+  auto result = listener->stop_listening(drain_timeout);
+  {
+    std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+    m_draining_listeners.erase(connection_name);
+  }
+  m_drained_cv.notify_all();
+  if (result.timed_out) {
+    ers::warning(DrainTimedOut(ERS_HERE, connection_name, result.drained, drain_timeout.count()));
+  }
+  return result;
 }
 
 void
@@ -135,8 +752,8 @@ NetworkManager::register_callback(std::string const& connection_or_topic,
                                   std::function<void(ipm::Receiver::Response)> callback)
 {
   TLOG_DEBUG(5) << "Registering callback on connection or topic " << connection_or_topic;
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
-  if (!m_connection_map.count(connection_or_topic) && !m_topic_map.count(connection_or_topic)) {
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+  if (find_resolution(connection_or_topic) == nullptr) {
     throw ConnectionNotFound(ERS_HERE, connection_or_topic);
   }
 
@@ -144,7 +761,27 @@ NetworkManager::register_callback(std::string const& connection_or_topic,
     throw ListenerNotRegistered(ERS_HERE, connection_or_topic);
   }
 
-  m_registered_listeners[connection_or_topic].set_callback(callback);
+  m_registered_listeners[connection_or_topic]->set_callback(callback);
+}
+
+void
+NetworkManager::register_callback(std::string const& connection_or_topic,
+                                  std::function<void(ipm::Receiver::Response)> callback,
+                                  KeyedDispatcher::key_extractor_t key_extractor,
+                                  size_t worker_count)
+{
+  TLOG_DEBUG(5) << "Registering callback with " << worker_count << " workers on connection or topic "
+                << connection_or_topic;
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+  if (find_resolution(connection_or_topic) == nullptr) {
+    throw ConnectionNotFound(ERS_HERE, connection_or_topic);
+  }
+
+  if (!is_listening_locked(connection_or_topic)) {
+    throw ListenerNotRegistered(ERS_HERE, connection_or_topic);
+  }
+
+  m_registered_listeners[connection_or_topic]->set_callback(callback, key_extractor, worker_count);
 }
 
 void
@@ -157,12 +794,40 @@ NetworkManager::clear_callback(std::string const& connection_or_topic)
 #pragma GCC diagnostic pop
 }
 
+void
+NetworkManager::register_request_handler(std::string const& connection_name, request_handler_t handler)
+{
+  TLOG_DEBUG(5) << "Registering request handler on connection " << connection_name;
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+  if (!m_connection_map.count(connection_name)) {
+    throw ConnectionNotFound(ERS_HERE, connection_name);
+  }
+
+  auto reply_connection = m_connection_map.at(connection_name).reply_connection;
+  if (reply_connection.empty()) {
+    throw NoReplyConnection(ERS_HERE, connection_name);
+  }
+
+  if (!is_listening_locked(connection_name)) {
+    throw ListenerNotRegistered(ERS_HERE, connection_name);
+  }
+
+  m_registered_listeners[connection_name]->set_callback(
+    [this, connection_name, reply_connection, handler](ipm::Receiver::Response request) {
+      handle_request(connection_name, reply_connection, handler, std::move(request));
+    });
+}
+
 void
 NetworkManager::subscribe(std::string const& topic)
 {
   TLOG_DEBUG(5) << "Start listening on topic " << topic;
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
-  if (!m_topic_map.count(topic)) {
+  std::unique_lock<InstrumentedMutex> lk(m_registration_mutex);
+  wait_for_drain(lk, topic);
+  if (find_resolution(topic) == nullptr && TopicPattern::is_pattern(topic)) {
+    register_pattern(topic);
+  }
+  if (!is_topic(topic)) {
     throw TopicNotFound(ERS_HERE, topic);
   }
 
@@ -170,19 +835,19 @@ NetworkManager::subscribe(std::string const& topic)
     throw ListenerAlreadyRegistered(ERS_HERE, topic);
   }
 
-  m_registered_listeners[topic].start_listening(topic);
+  start_listener(topic);
 }
 
 void
 NetworkManager::unsubscribe(std::string const& topic)
 {
   TLOG_DEBUG(5) << "Stop listening on topic " << topic;
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
   if (!is_listening_locked(topic)) {
     throw ListenerNotRegistered(ERS_HERE, topic);
   }
 
-  m_registered_listeners[topic].stop_listening();
+  m_registered_listeners[topic]->stop_listening();
 }
 
 void
@@ -210,39 +875,305 @@ NetworkManager::send_to(std::string const& connection_name,
                         ipm::Sender::duration_t timeout,
                         std::string const& topic)
 {
+  auto stats = get_connection_stats(connection_name);
+  auto latency = stats != nullptr ? stats->latency() : nullptr;
+  std::chrono::steady_clock::time_point start_time;
+  if (latency != nullptr) {
+    start_time = std::chrono::steady_clock::now();
+  }
+
   TLOG_DEBUG(20) << "Getting connection lock for connection " << connection_name;
   auto send_lock = get_connection_lock(connection_name);
+  if (latency != nullptr) {
+    latency->lock_wait.record(std::chrono::steady_clock::now() - start_time);
+  }
 
   TLOG_DEBUG(20) << "Checking connection map";
-  if (!m_connection_map.count(connection_name)) {
+  auto resolution = find_resolution(connection_name);
+  if (resolution == nullptr || resolution->kind == Resolution::Kind::Topic) {
     throw ConnectionNotFound(ERS_HERE, connection_name);
   }
 
   if (topic != "") {
-    bool match = false;
-    for (auto& configured_topic : m_connection_map.at(connection_name).topics) {
-      if (topic == configured_topic) {
-        match = true;
-        break;
-      }
-    }
-    if (!match) {
+    auto& topics = resolution->subscriptions;
+    if (std::find(topics.begin(), topics.end(), topic) == topics.end()) {
       ers::warning(ConnectionTopicNotFound(ERS_HERE, topic, connection_name));
     }
   }
 
-  TLOG_DEBUG(20) << "Checking sender plugins";
-  if (!is_connection_open(connection_name, ConnectionDirection::Send)) {
-    create_sender(connection_name);
+  if (stats != nullptr && stats->sender_health().reconnecting.load(std::memory_order_acquire)) {
+    throw ConnectionUnavailable(ERS_HERE, connection_name);
   }
 
+  // Receivers drop messages of more chunks than they reassemble, so such a message must not start going out
+  auto chunk_size = m_connection_map.at(connection_name).chunk_size;
+  if (chunk_size > 0 && size > chunk_size * Reassembler::s_max_chunks) {
+    throw MessageTooLarge(ERS_HERE, connection_name, size, chunk_size * Reassembler::s_max_chunks);
+  }
+
+  // A copy, since the plugin may be replaced while the connection lock is released between chunks
+  TLOG_DEBUG(20) << "Checking sender plugins";
+  auto sender_ptr = get_sender_plugin(connection_name);
+
   TLOG_DEBUG(20) << "Sending message";
-  std::shared_ptr<ipm::Sender> sender_ptr;
-  {
-    std::lock_guard<std::mutex> lk(m_sender_plugin_map_mutex);
-    sender_ptr = m_sender_plugins[connection_name];
+  auto envelope = stats != nullptr ? stats->envelope() : nullptr;
+  try {
+    send_message(send_lock, sender_ptr, envelope, chunk_size, buffer, size, timeout, topic);
+  } catch (ipm::SendTimeoutExpired const&) {
+    // A timeout is usually backpressure from a slow receiver, which another address would not help with
+    if (stats != nullptr && ++stats->sender_health().consecutive_timeouts >= s_failover_timeouts) {
+      fail_over_sender(connection_name);
+    }
+    throw;
+  } catch (ers::Issue const&) {
+    fail_over_sender(connection_name);
+    throw;
+  }
+
+  if (stats != nullptr) {
+    stats->sender_health().consecutive_timeouts = 0;
+    stats->record_send(size);
+  }
+  if (latency != nullptr) {
+    latency->send_time.record(std::chrono::steady_clock::now() - start_time);
+  }
+}
+
+void
+NetworkManager::send_message(std::unique_lock<InstrumentedMutex>& send_lock,
+                             std::shared_ptr<ipm::Sender> const& sender_ptr,
+                             EnvelopeStats* envelope,
+                             size_t chunk_size,
+                             const void* buffer,
+                             size_t size,
+                             ipm::Sender::duration_t timeout,
+                             std::string const& topic)
+{
+  if (envelope == nullptr) {
+    sender_ptr->send(buffer, size, timeout, topic);
+    return;
+  }
+
+  // The connection lock is held, so the sequence numbers for this connection cannot change under us
+  EnvelopeHeader header;
+  header.sequence_number = envelope->next_sequence_numbers[topic]++;
+  header.sender_id = m_sender_id;
+  if (chunk_size == 0 || size <= chunk_size) {
+    send_enveloped(sender_ptr, header, nullptr, buffer, size, timeout, topic);
+    return;
+  }
+
+  // The connection lock is released between chunks, so that other messages on the connection can go
+  // out between the chunks of a large one rather than after all of them
+  header.flags |= EnvelopeHeader::s_flag_chunk;
+  ChunkHeader chunk;
+  chunk.message_size = size;
+  for (chunk.offset = 0; chunk.offset < size; chunk.offset += chunk_size) {
+    if (chunk.offset > 0) {
+      send_lock.unlock();
+      std::this_thread::yield();
+      send_lock.lock();
+    }
+    send_enveloped(sender_ptr,
+                   header,
+                   &chunk,
+                   static_cast<const char*>(buffer) + chunk.offset,
+                   std::min<size_t>(chunk_size, size - chunk.offset),
+                   timeout,
+                   topic);
+    envelope->chunks_sent.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void
+NetworkManager::send_enveloped(std::shared_ptr<ipm::Sender> const& sender_ptr,
+                               EnvelopeHeader header,
+                               ChunkHeader const* chunk,
+                               const void* buffer,
+                               size_t size,
+                               ipm::Sender::duration_t timeout,
+                               std::string const& topic)
+{
+  header.send_time_ns =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  auto header_size = EnvelopeHeader::s_size + (chunk != nullptr ? ChunkHeader::s_size : 0);
+
+  // Stage large messages in the arena when there is one, so that the copy does not fault in fresh heap pages
+  thread_local std::vector<char> envelope_buffer;
+  ArenaBuffer arena_buffer;
+  std::optional<StagingBuffer> staging_buffer;
+  char* staging = nullptr;
+  if (m_arena != nullptr) {
+    arena_buffer = m_arena->allocate(header_size + size);
+    staging = arena_buffer.data();
+  } else {
+    staging = staging_buffer.emplace(envelope_buffer, header_size + size).data();
+  }
+  header.write(staging);
+  if (chunk != nullptr) {
+    chunk->write(staging + EnvelopeHeader::s_size);
+  }
+  memcpy(staging + header_size, buffer, size);
+  sender_ptr->send(staging, header_size + size, timeout, topic);
+}
+
+std::vector<std::string>
+NetworkManager::publish(std::string const& topic, const void* buffer, size_t size, ipm::Sender::duration_t timeout)
+{
+  auto resolution = find_resolution(topic);
+  if (resolution == nullptr || resolution->kind != Resolution::Kind::Topic || resolution->pattern) {
+    throw TopicNotFound(ERS_HERE, topic);
+  }
+
+  auto& connections = resolution->connections;
+  // Whether each send failed; other exceptions are passed on to the caller once all sends are done
+  std::vector<char> failed(connections.size(), false);
+  std::exception_ptr error;
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  auto send_one = [&](size_t idx) {
+    try {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      send_to(connections[idx], buffer, size, timeout, topic);
+#pragma GCC diagnostic pop
+    } catch (ers::Issue const& issue) {
+      TLOG_DEBUG(20) << "Publishing topic " << topic << " on connection " << connections[idx]
+                     << " failed: " << issue.message();
+      failed[idx] = true;
+    } catch (...) {
+      std::lock_guard<std::mutex> lk(done_mutex);
+      error = std::current_exception();
+    }
+  };
+
+  // A send usually only queues the message, so the pool's hand-off would cost more than it saves for one
+  // connection; with more, a connection which pushes back until timeout must not hold up the others
+  if (connections.size() < 2) {
+    for (size_t idx = 0; idx < connections.size(); ++idx) {
+      send_one(idx);
+    }
+  } else {
+    size_t pending = connections.size() - 1;
+    for (size_t idx = 1; idx < connections.size(); ++idx) {
+      m_publish_pool.submit([&, idx] {
+        send_one(idx);
+        std::lock_guard<std::mutex> lk(done_mutex);
+        if (--pending == 0) {
+          done_cv.notify_all();
+        }
+      });
+    }
+    send_one(0);
+    std::unique_lock<std::mutex> lk(done_mutex);
+    done_cv.wait(lk, [&] { return pending == 0; });
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  std::vector<std::string> failed_connections;
+  for (size_t idx = 0; idx < connections.size(); ++idx) {
+    if (failed[idx]) {
+      failed_connections.push_back(connections[idx]);
+    }
+  }
+  return failed_connections;
+}
+
+std::future<ipm::Receiver::Response>
+NetworkManager::request(std::string const& connection_name,
+                        const void* buffer,
+                        size_t size,
+                        ipm::Sender::duration_t timeout)
+{
+  // m_request_trackers is only modified by configure and reset, so no lock is needed here
+  auto tracker_it = m_request_trackers.find(connection_name);
+  if (tracker_it == m_request_trackers.end()) {
+    if (!m_connection_map.count(connection_name)) {
+      throw ConnectionNotFound(ERS_HERE, connection_name);
+    }
+    throw NoReplyConnection(ERS_HERE, connection_name);
+  }
+  auto& tracker = *tracker_it->second;
+  if (!tracker.reply_listener_started()) {
+    start_reply_listener(connection_name, tracker);
+  }
+
+  auto pending = tracker.add(timeout);
+  RequestHeader header;
+  header.kind = RequestHeader::Kind::Request;
+  header.correlation_id = pending.correlation_id;
+
+  thread_local std::vector<char> request_thread_buffer;
+  StagingBuffer request_buffer(request_thread_buffer, RequestHeader::s_size + size);
+  header.write(request_buffer.data());
+  memcpy(request_buffer.data() + RequestHeader::s_size, buffer, size);
+  try {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    send_to(connection_name, request_buffer.data(), request_buffer.size(), timeout);
+#pragma GCC diagnostic pop
+  } catch (ers::Issue const&) {
+    tracker.fail(pending.correlation_id, std::current_exception());
+  }
+  return std::move(pending.reply);
+}
+
+void
+NetworkManager::start_reply_listener(std::string const& connection_name, RequestTracker& tracker)
+{
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
+  if (tracker.reply_listener_started()) {
+    return;
+  }
+
+  auto reply_connection = m_connection_map.at(connection_name).reply_connection;
+  TLOG_DEBUG(5) << "Listening for replies to requests on " << connection_name << " on " << reply_connection;
+  if (is_listening_locked(reply_connection)) {
+    throw ListenerAlreadyRegistered(ERS_HERE, reply_connection);
+  }
+  start_listener(reply_connection);
+  m_registered_listeners[reply_connection]->set_callback([&tracker, reply_connection](ipm::Receiver::Response reply) {
+    RequestHeader header;
+    if (!header.read(reply.data.data(), reply.data.size()) || header.kind != RequestHeader::Kind::Reply) {
+      ers::warning(InvalidRequestMessage(ERS_HERE, reply_connection, reply.data.size()));
+      return;
+    }
+    reply.data.erase(reply.data.begin(), reply.data.begin() + RequestHeader::s_size);
+    tracker.complete(header.correlation_id, std::move(reply));
+  });
+  tracker.set_reply_listener_started();
+}
+
+void
+NetworkManager::handle_request(std::string const& connection_name,
+                               std::string const& reply_connection,
+                               request_handler_t const& handler,
+                               ipm::Receiver::Response&& request)
+{
+  RequestHeader header;
+  if (!header.read(request.data.data(), request.data.size()) || header.kind != RequestHeader::Kind::Request) {
+    ers::warning(InvalidRequestMessage(ERS_HERE, connection_name, request.data.size()));
+    return;
+  }
+  request.data.erase(request.data.begin(), request.data.begin() + RequestHeader::s_size);
+
+  // Without a reply, the requester's future fails with RequestTimedOut
+  std::vector<char> reply;
+  try {
+    auto payload = handler(std::move(request));
+    header.kind = RequestHeader::Kind::Reply;
+    reply.resize(RequestHeader::s_size + payload.size());
+    header.write(reply.data());
+    memcpy(reply.data() + RequestHeader::s_size, payload.data(), payload.size());
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    send_to(reply_connection, reply.data(), reply.size(), s_reply_timeout);
+#pragma GCC diagnostic pop
+  } catch (ers::Issue const& issue) {
+    ers::warning(ReplyFailed(ERS_HERE, connection_name, header.correlation_id, issue.message()));
   }
-  sender_ptr->send(buffer, size, timeout, topic);
 }
 
 ipm::Receiver::Response
@@ -250,103 +1181,184 @@ NetworkManager::receive_from(std::string const& connection_or_topic, ipm::Receiv
 {
   TLOG_DEBUG(19) << "START";
 
-  if (!m_connection_map.count(connection_or_topic) && !m_topic_map.count(connection_or_topic)) {
+  auto resolution = find_resolution(connection_or_topic);
+  if (resolution == nullptr) {
     throw ConnectionNotFound(ERS_HERE, connection_or_topic);
   }
 
-  if (!is_connection_open(connection_or_topic, ConnectionDirection::Recv)) {
-    TLOG_DEBUG(19) << "Creating receiver for connection or topic " << connection_or_topic;
-    create_receiver(connection_or_topic);
-  }
-
-  TLOG_DEBUG(19) << "Calling receive on connection or topic " << connection_or_topic;
+  auto& receiver_ptr = get_receiver_plugin(connection_or_topic);
+  auto stats = get_connection_stats(connection_or_topic);
+
+  // Chunks of a large message are received until it is complete, within the same timeout
+  auto deadline = std::chrono::steady_clock::now() + std::min<std::chrono::steady_clock::duration>(
+                                                        timeout, std::chrono::hours(24 * 365));
+  auto remaining = timeout;
+  while (true) {
+    TLOG_DEBUG(19) << "Calling receive on connection or topic " << connection_or_topic;
+    auto res = receiver_ptr->receive(remaining);
+
+    // A wildcard subscription subscribes to the pattern's prefix, which may take in topics that the rest
+    // of the pattern leaves out
+    bool complete = !resolution->pattern || resolution->pattern->matches(res.metadata);
+    if (complete && stats != nullptr && stats->envelope() != nullptr) {
+      complete = open_envelope(connection_or_topic, res, *stats->envelope());
+    }
+    if (!complete) {
+      if (timeout != ipm::Receiver::s_block) {
+        remaining = std::chrono::duration_cast<ipm::Receiver::duration_t>(
+          std::max<std::chrono::steady_clock::duration>(deadline - std::chrono::steady_clock::now(), {}));
+      }
+      continue;
+    }
+    if (stats != nullptr) {
+      stats->record_receive(res.data.size());
+    }
 
-  std::shared_ptr<ipm::Receiver> receiver_ptr;
-  {
-    std::lock_guard<std::mutex> lk(m_receiver_plugin_map_mutex);
-    receiver_ptr = m_receiver_plugins[connection_or_topic];
+    TLOG_DEBUG(19) << "END";
+    return res;
   }
-  auto res = receiver_ptr->receive(timeout);
-
-  TLOG_DEBUG(19) << "END";
-  return res;
 }
 
-std::string
+std::string const&
 NetworkManager::get_connection_string(std::string const& connection_name) const
 {
-  if (!m_connection_map.count(connection_name)) {
+  auto resolution = find_resolution(connection_name);
+  if (resolution == nullptr || resolution->kind == Resolution::Kind::Topic) {
     throw ConnectionNotFound(ERS_HERE, connection_name);
   }
 
-  return m_connection_map.at(connection_name).address;
+  return resolution->addresses[0];
 }
 
-std::vector<std::string>
+std::vector<std::string> const&
 NetworkManager::get_connection_strings(std::string const& topic) const
 {
-  if (!m_topic_map.count(topic)) {
+  auto resolution = find_resolution(topic);
+  if (resolution == nullptr || resolution->kind != Resolution::Kind::Topic) {
     throw TopicNotFound(ERS_HERE, topic);
   }
 
-  std::vector<std::string> output;
-  for (auto& connection : m_topic_map.at(topic)) {
-    output.push_back(m_connection_map.at(connection).address);
-  }
-
-  return output;
+  return resolution->addresses;
 }
 
 bool
 NetworkManager::is_topic(std::string const& topic) const
 {
-  if (m_connection_map.count(topic)) {
-    return false;
-  }
-  if (!m_topic_map.count(topic)) {
-    return false;
+  auto resolution = find_resolution(topic);
+  if (resolution != nullptr) {
+    return resolution->kind == Resolution::Kind::Topic;
   }
-
-  return true;
+  // A pattern not registered yet is matched against the topics without registering it
+  return TopicPattern::is_pattern(topic) && !m_topic_trie.match(TopicPattern(topic)).empty();
 }
 
 bool
 NetworkManager::is_connection(std::string const& connection_name) const
 {
-  if (m_topic_map.count(connection_name)) {
-    return false;
+  auto resolution = find_resolution(connection_name);
+  return resolution != nullptr && resolution->kind != Resolution::Kind::Topic;
+}
+
+bool
+NetworkManager::is_pubsub_connection(std::string const& connection_name) const
+{
+  auto resolution = find_resolution(connection_name);
+  return resolution != nullptr && resolution->kind == Resolution::Kind::PubSubConnection;
+}
+
+NetworkManager::Resolution const*
+NetworkManager::find_resolution(std::string const& connection_or_topic) const
+{
+  // m_resolutions is only modified by configure and reset, so no lock is needed here
+  auto resolution_it = m_resolutions.find(connection_or_topic);
+  if (resolution_it != m_resolutions.end()) {
+    return &resolution_it->second;
   }
-  if (!m_connection_map.count(connection_name)) {
-    return false;
+  if (TopicPattern::is_pattern(connection_or_topic)) {
+    auto subscription = find_pattern_subscription(connection_or_topic);
+    return subscription != nullptr ? &subscription->resolution : nullptr;
   }
+  return nullptr;
+}
 
-  return true;
+NetworkManager::PatternSubscription*
+NetworkManager::find_pattern_subscription(std::string const& pattern) const
+{
+  std::lock_guard<std::mutex> lk(m_pattern_mutex);
+  auto subscription_it = m_pattern_subscriptions.find(pattern);
+  return subscription_it != m_pattern_subscriptions.end() ? &subscription_it->second : nullptr;
 }
 
-bool
-NetworkManager::is_pubsub_connection(std::string const& connection_name) const
+NetworkManager::PatternSubscription*
+NetworkManager::register_pattern(std::string const& pattern)
 {
-  if (is_connection(connection_name)) {
-    return !m_connection_map.at(connection_name).topics.empty();
+  std::lock_guard<std::mutex> lk(m_pattern_mutex);
+  auto subscription_it = m_pattern_subscriptions.find(pattern);
+  if (subscription_it != m_pattern_subscriptions.end()) {
+    return &subscription_it->second;
   }
 
-  return false;
+  TopicPattern topic_pattern(pattern);
+  auto topics = m_topic_trie.match(topic_pattern);
+  if (topics.empty()) {
+    return nullptr;
+  }
+  TLOG_DEBUG(15) << "Pattern " << pattern << " matches " << topics.size() << " topics";
+
+  // One subscription serves every connection carrying a matching topic
+  std::vector<std::string> connection_names;
+  for (auto& topic : topics) {
+    for (auto& connection_name : m_topic_map.at(topic)) {
+      if (std::find(connection_names.begin(), connection_names.end(), connection_name) == connection_names.end()) {
+        connection_names.push_back(connection_name);
+      }
+    }
+  }
+  for (auto& connection_name : connection_names) {
+    if (m_connection_map.at(connection_name).envelope != m_connection_map.at(connection_names[0]).envelope) {
+      throw EnvelopeMismatch(ERS_HERE, pattern);
+    }
+  }
+
+  auto& subscription = m_pattern_subscriptions[pattern];
+  subscription.resolution = resolve_topic(connection_names);
+  subscription.resolution.subscriptions = { std::string(topic_pattern.prefix()) };
+  subscription.resolution.pattern = std::move(topic_pattern);
+  subscription.stats = make_topic_stats(connection_names);
+  return &subscription;
 }
 
 bool
 NetworkManager::is_listening(std::string const& connection_or_topic) const
 {
-  std::lock_guard<std::mutex> lk(m_registration_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_registration_mutex);
   return is_listening_locked(connection_or_topic);
 }
 
+void
+NetworkManager::wait_for_drain(std::unique_lock<InstrumentedMutex>& lk, std::string const& connection_or_topic)
+{
+  m_drained_cv.wait(lk, [&] { return m_draining_listeners.count(connection_or_topic) == 0; });
+}
+
+void
+NetworkManager::start_listener(std::string const& connection_or_topic)
+{
+  // Listeners receive through the NetworkManager which created them
+  auto& listener = m_registered_listeners[connection_or_topic];
+  if (listener == nullptr) {
+    listener = std::make_unique<Listener>(this);
+  }
+  listener->start_listening(connection_or_topic);
+}
+
 bool
 NetworkManager::is_listening_locked(std::string const& connection_or_topic) const
 {
   if (!m_registered_listeners.count(connection_or_topic))
     return false;
 
-  return m_registered_listeners.at(connection_or_topic).is_listening();
+  return m_registered_listeners.at(connection_or_topic)->is_listening();
 }
 
 bool
@@ -355,11 +1367,11 @@ NetworkManager::is_connection_open(std::string const& connection_name,
 {
   switch (direction) {
     case ConnectionDirection::Recv: {
-      std::lock_guard<std::mutex> recv_lk(m_receiver_plugin_map_mutex);
+      std::lock_guard<InstrumentedMutex> recv_lk(m_receiver_plugin_map_mutex);
       return m_receiver_plugins.count(connection_name);
     }
     case ConnectionDirection::Send: {
-      std::lock_guard<std::mutex> send_lk(m_sender_plugin_map_mutex);
+      std::lock_guard<InstrumentedMutex> send_lk(m_sender_plugin_map_mutex);
       return m_sender_plugins.count(connection_name);
     }
   }
@@ -370,22 +1382,11 @@ NetworkManager::is_connection_open(std::string const& connection_name,
 std::shared_ptr<ipm::Receiver>
 NetworkManager::get_receiver(std::string const& connection_or_topic)
 {
-  if (!m_connection_map.count(connection_or_topic) && !m_topic_map.count(connection_or_topic)) {
+  if (find_resolution(connection_or_topic) == nullptr) {
     throw ConnectionNotFound(ERS_HERE, connection_or_topic);
   }
 
-  if (!is_connection_open(connection_or_topic, ConnectionDirection::Recv)) {
-    TLOG_DEBUG(9) << "Creating receiver for connection or topic " << connection_or_topic;
-    create_receiver(connection_or_topic);
-  }
-
-  std::shared_ptr<ipm::Receiver> receiver_ptr;
-  {
-    std::lock_guard<std::mutex> lk(m_receiver_plugin_map_mutex);
-    receiver_ptr = m_receiver_plugins[connection_or_topic];
-  }
-
-  return receiver_ptr;
+  return get_receiver_plugin(connection_or_topic);
 }
 
 std::shared_ptr<ipm::Sender>
@@ -397,18 +1398,8 @@ NetworkManager::get_sender(std::string const& connection_name)
   }
 
   TLOG_DEBUG(10) << "Checking sender plugins";
-  if (!is_connection_open(connection_name, ConnectionDirection::Send)) {
-    create_sender(connection_name);
-  }
-
-  TLOG_DEBUG(10) << "Sending message";
-  std::shared_ptr<ipm::Sender> sender_ptr;
-  {
-    std::lock_guard<std::mutex> lk(m_sender_plugin_map_mutex);
-    sender_ptr = m_sender_plugins[connection_name];
-  }
-
-  return sender_ptr;
+  auto send_lock = get_connection_lock(connection_name);
+  return get_sender_plugin(connection_name);
 }
 
 std::shared_ptr<ipm::Subscriber>
@@ -416,56 +1407,96 @@ NetworkManager::get_subscriber(std::string const& topic)
 {
   TLOG_DEBUG(9) << "START";
 
-  if (!m_topic_map.count(topic)) {
+  if (find_resolution(topic) == nullptr && TopicPattern::is_pattern(topic)) {
+    register_pattern(topic);
+  }
+  if (!is_topic(topic)) {
     throw ConnectionNotFound(ERS_HERE, topic);
   }
 
-  if (!is_connection_open(topic, ConnectionDirection::Recv)) {
-    TLOG_DEBUG(9) << "Creating receiver for topic " << topic;
-    create_receiver(topic);
+  return std::dynamic_pointer_cast<ipm::Subscriber>(get_receiver_plugin(topic));
+}
+
+std::shared_ptr<ipm::Sender> const&
+NetworkManager::get_sender_plugin(std::string const& connection_name)
+{
+  thread_local PluginCache<ipm::Sender> cache;
+  auto epoch = s_plugin_epoch.load(std::memory_order_acquire);
+  if (auto cached = cache.find(this, connection_name, epoch)) {
+    return *cached;
   }
 
-  std::shared_ptr<ipm::Subscriber> subscriber_ptr;
-  {
-    std::lock_guard<std::mutex> lk(m_receiver_plugin_map_mutex);
-    subscriber_ptr = std::dynamic_pointer_cast<ipm::Subscriber>(m_receiver_plugins[topic]);
+  if (!is_connection_open(connection_name, ConnectionDirection::Send)) {
+    create_sender(connection_name);
+  }
+
+  std::lock_guard<InstrumentedMutex> lk(m_sender_plugin_map_mutex);
+  auto& sender_ptr = m_sender_plugins.at(connection_name);
+  cache.entries[this][connection_name] = &sender_ptr;
+  return sender_ptr;
+}
+
+std::shared_ptr<ipm::Receiver> const&
+NetworkManager::get_receiver_plugin(std::string const& connection_or_topic)
+{
+  thread_local PluginCache<ipm::Receiver> cache;
+  auto epoch = s_plugin_epoch.load(std::memory_order_acquire);
+  if (auto cached = cache.find(this, connection_or_topic, epoch)) {
+    return *cached;
+  }
+
+  if (!is_connection_open(connection_or_topic, ConnectionDirection::Recv)) {
+    TLOG_DEBUG(9) << "Creating receiver for connection or topic " << connection_or_topic;
+    create_receiver(connection_or_topic);
   }
-  return subscriber_ptr;
+
+  std::lock_guard<InstrumentedMutex> lk(m_receiver_plugin_map_mutex);
+  auto& receiver_ptr = m_receiver_plugins.at(connection_or_topic);
+  cache.entries[this][connection_or_topic] = &receiver_ptr;
+  return receiver_ptr;
 }
 
 void
 NetworkManager::create_receiver(std::string const& connection_or_topic)
 {
   TLOG_DEBUG(12) << "START";
-  std::lock_guard<std::mutex> lk(m_receiver_plugin_map_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_receiver_plugin_map_mutex);
   if (m_receiver_plugins.count(connection_or_topic))
     return;
 
-  auto plugin_type = ipm::get_recommended_plugin_name(
-    is_topic(connection_or_topic) || is_pubsub_connection(connection_or_topic) ? ipm::IpmPluginType::Subscriber
-                                                                               : ipm::IpmPluginType::Receiver);
+  auto resolution = find_resolution(connection_or_topic);
+  if (resolution == nullptr) {
+    throw ConnectionNotFound(ERS_HERE, connection_or_topic);
+  }
 
-  TLOG_DEBUG(12) << "Creating plugin for connection or topic " << connection_or_topic << " of type " << plugin_type;
-  m_receiver_plugins[connection_or_topic] = dunedaq::ipm::make_ipm_receiver(plugin_type);
+  // Subscribers merge all the addresses they are given themselves; point-to-point stripes need a StripedReceiver
+  bool is_subscriber = resolution->kind != Resolution::Kind::Connection;
+  if (!is_subscriber && resolution->addresses.size() > 1) {
+    TLOG_DEBUG(12) << "Creating receiver for connection " << connection_or_topic << " with "
+                   << resolution->addresses.size() << " stripes";
+    std::vector<std::shared_ptr<ipm::Receiver>> stripes;
+    for (auto& address : resolution->addresses) {
+      stripes.push_back(make_receiver_plugin(address, false));
+    }
+    m_receiver_plugins[connection_or_topic] =
+      std::make_shared<StripedReceiver>(std::move(stripes), m_connection_map.at(connection_or_topic).stripe_ordered);
+  } else {
+    TLOG_DEBUG(12) << "Creating receiver for connection or topic " << connection_or_topic;
+    m_receiver_plugins[connection_or_topic] = make_receiver_plugin(resolution->addresses[0], is_subscriber);
+  }
   try {
-    nlohmann::json config_json;
-    if (is_topic(connection_or_topic)) {
-      config_json["connection_strings"] = get_connection_strings(connection_or_topic);
+    auto config_json = resolution->tuning;
+    if (resolution->kind == Resolution::Kind::Topic || resolution->addresses.size() > 1) {
+      config_json["connection_strings"] = resolution->addresses;
     } else {
-      config_json["connection_string"] = get_connection_string(connection_or_topic);
+      config_json["connection_string"] = resolution->addresses[0];
     }
     m_receiver_plugins[connection_or_topic]->connect_for_receives(config_json);
 
-    if (is_topic(connection_or_topic)) {
-      TLOG_DEBUG(12) << "Subscribing to topic " << connection_or_topic << " after connect_for_receives";
+    if (is_subscriber) {
+      TLOG_DEBUG(12) << "Subscribing to topics of " << connection_or_topic << " after connect_for_receives";
       auto subscriber = std::dynamic_pointer_cast<ipm::Subscriber>(m_receiver_plugins[connection_or_topic]);
-      subscriber->subscribe(connection_or_topic);
-    }
-
-    if (is_pubsub_connection(connection_or_topic)) {
-      TLOG_DEBUG(12) << "Subscribing to topics on " << connection_or_topic << " after connect_for_receives";
-      auto subscriber = std::dynamic_pointer_cast<ipm::Subscriber>(m_receiver_plugins[connection_or_topic]);
-      for (auto& topic : m_connection_map[connection_or_topic].topics) {
+      for (auto& topic : resolution->subscriptions) {
         subscriber->subscribe(topic);
       }
     }
@@ -481,36 +1512,248 @@ void
 NetworkManager::create_sender(std::string const& connection_name)
 {
   TLOG_DEBUG(11) << "Getting create mutex";
-  std::lock_guard<std::mutex> lk(m_sender_plugin_map_mutex);
+  std::lock_guard<InstrumentedMutex> lk(m_sender_plugin_map_mutex);
   TLOG_DEBUG(11) << "Checking plugin list";
   if (m_sender_plugins.count(connection_name))
     return;
 
-  auto plugin_type = ipm::get_recommended_plugin_name(
-    is_pubsub_connection(connection_name) ? ipm::IpmPluginType::Publisher : ipm::IpmPluginType::Sender);
+  auto stats = get_connection_stats(connection_name);
+  if (stats == nullptr) {
+    throw ConnectionNotFound(ERS_HERE, connection_name);
+  }
+  auto& health = stats->sender_health();
+  if (health.reconnecting.load(std::memory_order_acquire)) {
+    throw ConnectionUnavailable(ERS_HERE, connection_name);
+  }
 
-  TLOG_DEBUG(11) << "Creating sender plugin for connection " << connection_name << " of type " << plugin_type;
-  m_sender_plugins[connection_name] = dunedaq::ipm::make_ipm_sender(plugin_type);
-  TLOG_DEBUG(11) << "Connecting sender plugin for connection " << connection_name;
+  auto& connection = m_connection_map.at(connection_name);
   try {
-    m_sender_plugins[connection_name]->connect_for_sends(
-      { { "connection_string", m_connection_map[connection_name].address } });
+    auto connected = connect_sender(connection_name, health.address_index.load());
+    install_sender(connection_name, std::move(connected.first), connected.second);
   } catch (ers::Issue const&) {
-    m_sender_plugins.erase(connection_name);
+    // With a reconnect policy, further sends fail straight away while the connect is retried in the background
+    if (connection.reconnect_backoff_ms > 0) {
+      std::chrono::milliseconds backoff(connection.reconnect_backoff_ms);
+      health.reconnecting.store(true, std::memory_order_release);
+      m_reconnector.schedule(
+        connection_name, backoff, backoff, std::chrono::milliseconds(connection.reconnect_backoff_max_ms));
+    }
     throw;
   }
 }
 
-std::unique_lock<std::mutex>
+std::pair<std::shared_ptr<ipm::Sender>, size_t>
+NetworkManager::connect_sender(std::string const& connection_name, size_t first_index) const
+{
+  auto& connection = m_connection_map.at(connection_name);
+  auto resolution = find_resolution(connection_name);
+  auto config_json = resolution->tuning;
+  auto is_publisher = resolution->kind == Resolution::Kind::PubSubConnection;
+
+  // Striped connections have no alternate addresses, so they are connected in one go
+  if (!connection.stripe_addresses.empty()) {
+    TLOG_DEBUG(11) << "Creating sender for connection " << connection_name << " with "
+                   << resolution->addresses.size() << " stripes";
+    std::vector<std::shared_ptr<ipm::Sender>> stripes;
+    for (auto& address : resolution->addresses) {
+      stripes.push_back(make_sender_plugin(address, is_publisher));
+    }
+    auto plugin = std::make_shared<StripedSender>(std::move(stripes), connection.stripe_policy);
+    config_json["connection_strings"] = resolution->addresses;
+    plugin->connect_for_sends(config_json);
+    return std::make_pair(plugin, 0);
+  }
+
+  auto address_count = 1 + connection.alternate_addresses.size();
+  for (size_t attempt = 0;; ++attempt) {
+    auto index = (first_index + attempt) % address_count;
+    auto& address = index == 0 ? connection.address : connection.alternate_addresses[index - 1];
+
+    std::shared_ptr<ipm::Sender> plugin;
+    try {
+      plugin = make_sender_plugin(address, is_publisher);
+      TLOG_DEBUG(11) << "Connecting sender plugin for connection " << connection_name << " to " << address;
+      config_json["connection_string"] = address;
+      plugin->connect_for_sends(config_json);
+      return std::make_pair(plugin, index);
+    } catch (ers::Issue const& issue) {
+      if (attempt + 1 == address_count) {
+        throw;
+      }
+      TLOG_DEBUG(11) << "Unable to connect sender for connection " << connection_name << " to " << address << ": "
+                     << issue.message();
+    }
+  }
+}
+
+void
+NetworkManager::install_sender(std::string const& connection_name,
+                               std::shared_ptr<ipm::Sender> plugin,
+                               size_t address_index)
+{
+  m_sender_plugins[connection_name] = std::move(plugin);
+
+  auto& health = get_connection_stats(connection_name)->sender_health();
+  if (health.address_index.exchange(address_index) != address_index) {
+    TLOG_DEBUG(11) << "Connection " << connection_name << " failed over to address " << address_index;
+    health.failovers.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool
+NetworkManager::reconnect_sender(std::string const& connection_name)
+{
+  auto& health = get_connection_stats(connection_name)->sender_health();
+  auto address_count = 1 + m_connection_map.at(connection_name).alternate_addresses.size();
+  auto first_index = health.address_index.load();
+  if (is_connection_open(connection_name, ConnectionDirection::Send)) {
+    // The sender in use failed, so start with the next address
+    first_index = (first_index + 1) % address_count;
+  }
+
+  std::pair<std::shared_ptr<ipm::Sender>, size_t> connected;
+  try {
+    connected = connect_sender(connection_name, first_index);
+  } catch (ers::Issue const& issue) {
+    TLOG_DEBUG(11) << "Unable to reconnect sender for connection " << connection_name << ": " << issue.message();
+    return false;
+  }
+
+  // Sends take the plugin under the connection lock, so it is replaced under it; a message being sent in chunks
+  // keeps the plugin it started on
+  auto send_lock = get_connection_lock(connection_name);
+  {
+    std::lock_guard<InstrumentedMutex> lk(m_sender_plugin_map_mutex);
+    install_sender(connection_name, std::move(connected.first), connected.second);
+  }
+  health.reconnects.fetch_add(1, std::memory_order_relaxed);
+  health.reconnecting.store(false, std::memory_order_release);
+  TLOG_DEBUG(5) << "Reconnected sender for connection " << connection_name;
+  return true;
+}
+
+void
+NetworkManager::fail_over_sender(std::string const& connection_name)
+{
+  auto& connection = m_connection_map.at(connection_name);
+  if (connection.alternate_addresses.empty() || connection.reconnect_backoff_ms == 0) {
+    return;
+  }
+
+  TLOG_DEBUG(5) << "Send failed on connection " << connection_name << ", failing over";
+  auto& health = get_connection_stats(connection_name)->sender_health();
+  health.consecutive_timeouts = 0;
+  health.reconnecting.store(true, std::memory_order_release);
+  std::chrono::milliseconds backoff(connection.reconnect_backoff_ms);
+  m_reconnector.schedule(connection_name,
+                         std::chrono::milliseconds(0),
+                         backoff,
+                         std::chrono::milliseconds(connection.reconnect_backoff_max_ms));
+}
+
+bool
+NetworkManager::open_envelope(std::string const& connection_or_topic,
+                              ipm::Receiver::Response& response,
+                              EnvelopeStats& envelope) const
+{
+  EnvelopeHeader header;
+  if (!header.read(response.data.data(), response.data.size())) {
+    envelope.invalid_envelopes.fetch_add(1, std::memory_order_relaxed);
+    ers::warning(InvalidEnvelope(ERS_HERE, connection_or_topic, response.data.size()));
+    return true;
+  }
+
+  // A message's sequence number is checked when its first chunk arrives, since the chunks of
+  // messages sent after it may complete theirs sooner
+  bool check_sequence = true;
+  if ((header.flags & EnvelopeHeader::s_flag_chunk) != 0) {
+    ChunkHeader chunk;
+    auto chunk_data = response.data.data() + EnvelopeHeader::s_size;
+    auto chunk_size = response.data.size() - EnvelopeHeader::s_size;
+    if (!chunk.read(chunk_data, chunk_size)) {
+      envelope.invalid_envelopes.fetch_add(1, std::memory_order_relaxed);
+      ers::warning(InvalidEnvelope(ERS_HERE, connection_or_topic, response.data.size()));
+      return false;
+    }
+    envelope.chunks_received.fetch_add(1, std::memory_order_relaxed);
+
+    std::vector<char> data;
+    auto result = envelope.reassembler.add(header.sender_id,
+                                           response.metadata,
+                                           header.sequence_number,
+                                           chunk,
+                                           chunk_data + ChunkHeader::s_size,
+                                           chunk_size - ChunkHeader::s_size,
+                                           data);
+    if (result.status == Reassembler::Status::Invalid) {
+      envelope.invalid_envelopes.fetch_add(1, std::memory_order_relaxed);
+      ers::warning(InvalidEnvelope(ERS_HERE, connection_or_topic, response.data.size()));
+      return false;
+    }
+    if (result.first_chunk) {
+      update_sequence(envelope, header, response.metadata);
+    }
+    if (result.status == Reassembler::Status::Incomplete) {
+      return false;
+    }
+    response.data = std::move(data);
+    check_sequence = false;
+  } else {
+    response.data.erase(response.data.begin(), response.data.begin() + EnvelopeHeader::s_size);
+  }
+
+  auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch())
+                  .count();
+  envelope.one_way_latency.record(now_ns > static_cast<int64_t>(header.send_time_ns) ? now_ns - header.send_time_ns
+                                                                                        : 0);
+
+  if (check_sequence) {
+    update_sequence(envelope, header, response.metadata);
+  }
+  return true;
+}
+
+void
+NetworkManager::update_sequence(EnvelopeStats& envelope, EnvelopeHeader const& header, std::string const& topic) const
+{
+  // On a pub/sub connection the sender numbers each topic separately; the topic is in the metadata
+  auto result = envelope.sequence_tracker.update(header.sender_id, topic, header.sequence_number);
+  if (result.missing > 0) {
+    envelope.missing_messages.fetch_add(result.missing, std::memory_order_relaxed);
+  }
+  if (result.out_of_order) {
+    envelope.out_of_order_messages.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (result.recovered) {
+    envelope.missing_messages.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+ConnectionStats*
+NetworkManager::get_connection_stats(std::string const& connection_or_topic) const
+{
+  // m_connection_stats is only modified by configure and reset, so no lock is needed here
+  auto stats_it = m_connection_stats.find(connection_or_topic);
+  if (stats_it != m_connection_stats.end()) {
+    return stats_it->second.get();
+  }
+  if (TopicPattern::is_pattern(connection_or_topic)) {
+    auto subscription = find_pattern_subscription(connection_or_topic);
+    return subscription != nullptr ? subscription->stats.get() : nullptr;
+  }
+  return nullptr;
+}
+
+std::unique_lock<InstrumentedMutex>
 NetworkManager::get_connection_lock(std::string const& connection_name) const
 {
-  static std::mutex connection_map_mutex;
-  std::unique_lock<std::mutex> lk(connection_map_mutex);
+  std::unique_lock<InstrumentedMutex> lk(m_connection_map_mutex);
   auto& mut = m_connection_mutexes[connection_name];
   lk.unlock();
 
   TLOG_DEBUG(13) << "Mutex for connection " << connection_name << " is at " << &mut;
-  std::unique_lock<std::mutex> conn_lk(mut);
+  std::unique_lock<InstrumentedMutex> conn_lk(mut);
   return conn_lk;
 }
 
@@ -0,0 +1,109 @@
+/**
+ *
+ * @file Reconnector.cpp Background retries, with exponential backoff, of failed connects
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Reconnector.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace dunedaq::networkmanager {
+
+Reconnector::Reconnector(attempt_t attempt)
+  : m_attempt(std::move(attempt))
+{}
+
+Reconnector::~Reconnector()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = true;
+    m_tasks.clear();
+  }
+  m_changed.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void
+Reconnector::schedule(std::string const& name,
+                      std::chrono::milliseconds first_delay,
+                      std::chrono::milliseconds backoff,
+                      std::chrono::milliseconds max_backoff)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (m_tasks.count(name) || m_attempt_in_progress == name) {
+    return;
+  }
+
+  TLOG_DEBUG(22) << "Scheduling reconnect of " << name << " in " << first_delay.count() << " ms";
+  m_tasks[name] = { std::chrono::steady_clock::now() + first_delay, backoff, std::max(max_backoff, backoff) };
+  if (!m_thread.joinable()) {
+    m_thread = std::thread([this] { thread_loop(); });
+  }
+  m_changed.notify_all();
+}
+
+bool
+Reconnector::is_scheduled(std::string const& name) const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_tasks.count(name) || m_attempt_in_progress == name;
+}
+
+void
+Reconnector::clear()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  m_tasks.clear();
+  ++m_generation;
+  m_changed.wait(lk, [&] { return m_attempt_in_progress.empty(); });
+}
+
+void
+Reconnector::thread_loop()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  while (!m_stop) {
+    auto next_it = std::min_element(m_tasks.begin(), m_tasks.end(), [](auto const& lhs, auto const& rhs) {
+      return lhs.second.next_attempt < rhs.second.next_attempt;
+    });
+    if (next_it == m_tasks.end()) {
+      m_changed.wait(lk);
+      continue;
+    }
+    if (next_it->second.next_attempt > std::chrono::steady_clock::now()) {
+      m_changed.wait_until(lk, next_it->second.next_attempt);
+      continue;
+    }
+
+    auto task = next_it->second;
+    auto generation = m_generation;
+    m_attempt_in_progress = next_it->first;
+    m_tasks.erase(next_it);
+    lk.unlock();
+
+    TLOG_DEBUG(22) << "Attempting to reconnect " << m_attempt_in_progress;
+    bool success = m_attempt(m_attempt_in_progress);
+
+    lk.lock();
+    if (!success && !m_stop && generation == m_generation) {
+      task.next_attempt = std::chrono::steady_clock::now() + task.backoff;
+      task.backoff = std::min(task.backoff * 2, task.max_backoff);
+      m_tasks[m_attempt_in_progress] = task;
+    }
+    m_attempt_in_progress.clear();
+    m_changed.notify_all();
+  }
+}
+
+} // namespace dunedaq::networkmanager
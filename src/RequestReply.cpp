@@ -0,0 +1,166 @@
+/**
+ *
+ * @file RequestReply.cpp Correlation of requests and replies exchanged over a pair of connections
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/RequestReply.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace dunedaq::networkmanager {
+
+void
+RequestHeader::write(char* destination) const
+{
+  memcpy(destination, &magic, sizeof(magic));
+  memcpy(destination + 4, &version, sizeof(version));
+  memcpy(destination + 6, &kind, sizeof(kind));
+  memcpy(destination + 8, &correlation_id, sizeof(correlation_id));
+}
+
+bool
+RequestHeader::read(const char* data, size_t size)
+{
+  if (size < s_size) {
+    return false;
+  }
+
+  memcpy(&magic, data, sizeof(magic));
+  memcpy(&version, data + 4, sizeof(version));
+  if (magic != s_magic || version != s_version) {
+    return false;
+  }
+
+  memcpy(&kind, data + 6, sizeof(kind));
+  memcpy(&correlation_id, data + 8, sizeof(correlation_id));
+  return kind == Kind::Request || kind == Kind::Reply;
+}
+
+RequestTracker::RequestTracker(std::string const& name)
+  : m_name(name)
+  , m_next_correlation_id(static_cast<uint64_t>(std::random_device()()) << 32 | 1)
+{}
+
+RequestTracker::~RequestTracker()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = true;
+    for (auto& entry_pair : m_pending) {
+      entry_pair.second.promise.set_exception(
+        std::make_exception_ptr(RequestCancelled(ERS_HERE, m_name, entry_pair.first)));
+    }
+    m_pending.clear();
+    m_deadlines.clear();
+  }
+  m_deadline_changed.notify_all();
+  if (m_expiry_thread.joinable()) {
+    m_expiry_thread.join();
+  }
+}
+
+RequestTracker::PendingRequest
+RequestTracker::add(std::chrono::milliseconds timeout)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto correlation_id = m_next_correlation_id++;
+  auto& entry = m_pending[correlation_id];
+  entry.timeout = timeout;
+  entry.has_deadline = timeout != ipm::Receiver::s_block;
+  if (entry.has_deadline) {
+    if (!m_expiry_thread.joinable()) {
+      m_expiry_thread = std::thread([this] { expiry_loop(); });
+    }
+    entry.deadline = m_deadlines.emplace(std::chrono::steady_clock::now() + timeout, correlation_id);
+    if (entry.deadline == m_deadlines.begin()) {
+      m_deadline_changed.notify_one();
+    }
+  }
+  return { correlation_id, entry.promise.get_future() };
+}
+
+void
+RequestTracker::erase(std::unordered_map<uint64_t, Entry>::iterator entry_it)
+{
+  if (entry_it->second.has_deadline) {
+    m_deadlines.erase(entry_it->second.deadline);
+  }
+  m_pending.erase(entry_it);
+}
+
+void
+RequestTracker::fail(uint64_t correlation_id, std::exception_ptr error)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto entry_it = m_pending.find(correlation_id);
+  if (entry_it != m_pending.end()) {
+    entry_it->second.promise.set_exception(error);
+    erase(entry_it);
+  }
+}
+
+bool
+RequestTracker::complete(uint64_t correlation_id, ipm::Receiver::Response&& reply)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto entry_it = m_pending.find(correlation_id);
+  if (entry_it == m_pending.end()) {
+    TLOG_DEBUG(21) << "Reply " << correlation_id << " on " << m_name << " has no pending request";
+    m_late_replies.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  entry_it->second.promise.set_value(std::move(reply));
+  erase(entry_it);
+  m_completed.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+size_t
+RequestTracker::pending() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_pending.size();
+}
+
+void
+RequestTracker::fill_info(connectioninfo::RequestInfo& info) const
+{
+  info.pending = pending();
+  info.completed = m_completed.load(std::memory_order_relaxed);
+  info.timed_out = m_timed_out.load(std::memory_order_relaxed);
+  info.late_replies = m_late_replies.load(std::memory_order_relaxed);
+}
+
+void
+RequestTracker::expiry_loop()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  while (!m_stop) {
+    if (m_deadlines.empty()) {
+      m_deadline_changed.wait(lk);
+      continue;
+    }
+    m_deadline_changed.wait_until(lk, m_deadlines.begin()->first);
+
+    auto now = std::chrono::steady_clock::now();
+    while (!m_deadlines.empty() && m_deadlines.begin()->first <= now) {
+      auto entry_it = m_pending.find(m_deadlines.begin()->second);
+      entry_it->second.promise.set_exception(std::make_exception_ptr(
+        RequestTimedOut(ERS_HERE, m_name, entry_it->first, entry_it->second.timeout.count())));
+      erase(entry_it);
+      m_timed_out.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace dunedaq::networkmanager
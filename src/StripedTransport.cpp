@@ -0,0 +1,247 @@
+/**
+ *
+ * @file StripedTransport.cpp Senders and receivers spreading one connection over several sockets
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/StripedTransport.hpp"
+#include "networkmanager/Envelope.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::networkmanager {
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+// Blocking calls (ipm's s_block) wait for a year rather than until time_point::max(), which
+// would overflow when compared with durations
+clock_type::time_point
+deadline_for(std::chrono::milliseconds timeout)
+{
+  return clock_type::now() + std::min<clock_type::duration>(timeout, std::chrono::hours(24 * 365));
+}
+
+// The config of each stripe: the given one, with the stripe's own address
+std::vector<nlohmann::json>
+stripe_configs(const nlohmann::json& connection_info, size_t stripe_count)
+{
+  auto addresses = connection_info.value<std::vector<std::string>>("connection_strings", {});
+  if (addresses.size() != stripe_count) {
+    throw OperationFailed(ERS_HERE,
+                          "Striped connection with " + std::to_string(stripe_count) + " stripes was given " +
+                            std::to_string(addresses.size()) + " addresses");
+  }
+
+  auto stripe_info = connection_info;
+  stripe_info.erase("connection_strings");
+  std::vector<nlohmann::json> configs;
+  for (auto& address : addresses) {
+    stripe_info["connection_string"] = address;
+    configs.push_back(stripe_info);
+  }
+  return configs;
+}
+} // namespace
+
+StripedSender::StripedSender(std::vector<std::shared_ptr<ipm::Sender>> stripes, nwmgr::StripePolicy policy)
+  : m_stripes(std::move(stripes))
+  , m_policy(policy)
+{}
+
+void
+StripedSender::connect_for_sends(const nlohmann::json& connection_info)
+{
+  auto configs = stripe_configs(connection_info, m_stripes.size());
+  for (size_t idx = 0; idx < m_stripes.size(); ++idx) {
+    m_stripes[idx]->connect_for_sends(configs[idx]);
+  }
+}
+
+bool
+StripedSender::can_send() const noexcept
+{
+  return !m_stripes.empty() &&
+         std::all_of(m_stripes.begin(), m_stripes.end(), [](auto& stripe) { return stripe->can_send(); });
+}
+
+void
+StripedSender::send_(const void* message, message_size_t N, const duration_t& timeout, std::string const& metadata)
+{
+  auto first = m_next_stripe.fetch_add(1, std::memory_order_relaxed) % m_stripes.size();
+  if (m_policy == nwmgr::StripePolicy::least_loaded) {
+    for (size_t offset = 0; offset < m_stripes.size(); ++offset) {
+      try {
+        m_stripes[(first + offset) % m_stripes.size()]->send(message, N, s_no_block, metadata);
+        return;
+      } catch (ipm::SendTimeoutExpired const&) {
+        // This stripe's queue is full, try the next one
+      }
+    }
+  }
+  m_stripes[first]->send(message, N, timeout, metadata);
+}
+
+StripedReceiver::StripedReceiver(std::vector<std::shared_ptr<ipm::Receiver>> stripes, bool ordered)
+  : m_stripes(std::move(stripes))
+  , m_ordered(ordered)
+{}
+
+void
+StripedReceiver::connect_for_receives(const nlohmann::json& connection_info)
+{
+  auto configs = stripe_configs(connection_info, m_stripes.size());
+  for (size_t idx = 0; idx < m_stripes.size(); ++idx) {
+    m_stripes[idx]->connect_for_receives(configs[idx]);
+  }
+}
+
+bool
+StripedReceiver::can_receive() const noexcept
+{
+  return !m_stripes.empty() &&
+         std::all_of(m_stripes.begin(), m_stripes.end(), [](auto& stripe) { return stripe->can_receive(); });
+}
+
+ipm::Receiver::Response
+StripedReceiver::receive_(const duration_t& timeout)
+{
+  auto deadline = deadline_for(timeout);
+  std::lock_guard<std::mutex> lk(m_mutex);
+  while (true) {
+    Response response;
+    auto now = clock_type::now();
+    if (m_ordered && pop_due(response, now)) {
+      return response;
+    }
+
+    auto wait = std::min<duration_t>(
+      s_stripe_wait, std::chrono::ceil<duration_t>(std::max<clock_type::duration>(deadline - now, duration_t(0))));
+    if (m_ordered) {
+      wait = std::min(wait, time_to_next_due(now));
+    }
+    if (poll(response, wait)) {
+      if (!m_ordered || !hold(response, clock_type::now())) {
+        return response;
+      }
+    } else if (clock_type::now() >= deadline) {
+      throw ipm::ReceiveTimeoutExpired(ERS_HERE, timeout.count());
+    }
+  }
+}
+
+bool
+StripedReceiver::poll(Response& response, duration_t timeout)
+{
+  for (size_t offset = 0; offset <= m_stripes.size(); ++offset) {
+    // The extra last round waits on the stripe after the one which last had a message
+    bool wait = offset == m_stripes.size();
+    if (wait && timeout.count() == 0) {
+      return false;
+    }
+    auto idx = (m_next_stripe + offset) % m_stripes.size();
+    try {
+      response = m_stripes[idx]->receive(wait ? timeout : s_no_block);
+      m_next_stripe = (idx + 1) % m_stripes.size();
+      return true;
+    } catch (ipm::ReceiveTimeoutExpired const&) {
+      // Nothing on this stripe yet
+    }
+  }
+  m_next_stripe = (m_next_stripe + 1) % m_stripes.size();
+  return false;
+}
+
+bool
+StripedReceiver::hold(Response& response, clock_type::time_point now)
+{
+  EnvelopeHeader header;
+  if (!header.read(response.data.data(), response.data.size())) {
+    return false;
+  }
+  ChunkHeader chunk;
+  uint64_t chunk_size = 0;
+  if ((header.flags & EnvelopeHeader::s_flag_chunk) != 0 &&
+      chunk.read(response.data.data() + EnvelopeHeader::s_size, response.data.size() - EnvelopeHeader::s_size)) {
+    chunk_size = response.data.size() - EnvelopeHeader::s_size - ChunkHeader::s_size;
+  }
+
+  auto& stream = m_streams[std::make_pair(header.sender_id, response.metadata)];
+  if (header.sequence_number < stream.next_sequence_number) {
+    // Too late, or a duplicate: there is no turn left to wait for
+    return false;
+  }
+  if (header.sequence_number == stream.next_sequence_number) {
+    take_turn(stream, chunk_size, chunk.message_size);
+    return false;
+  }
+  // A repeated chunk is passed on as well, rather than replacing the one already held
+  auto key = std::make_pair(header.sequence_number, chunk.offset);
+  if (stream.held.count(key) != 0) {
+    return false;
+  }
+  stream.held.emplace(key, Held{ std::move(response), now, chunk_size, chunk.message_size });
+  return true;
+}
+
+bool
+StripedReceiver::pop_due(Response& response, clock_type::time_point now)
+{
+  for (auto& stream_pair : m_streams) {
+    auto& stream = stream_pair.second;
+    if (stream.held.empty()) {
+      continue;
+    }
+    auto first = stream.held.begin();
+    auto sequence_number = first->first.first;
+    auto& held = first->second;
+    if (sequence_number <= stream.next_sequence_number || now - held.arrival_time >= s_reorder_window ||
+        stream.held.size() > s_reorder_capacity) {
+      if (sequence_number > stream.next_sequence_number) {
+        // The missing messages are given up
+        stream.next_sequence_number = sequence_number;
+        stream.next_bytes_passed = 0;
+      }
+      if (sequence_number == stream.next_sequence_number) {
+        take_turn(stream, held.chunk_size, held.message_size);
+      }
+      response = std::move(held.response);
+      stream.held.erase(first);
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+StripedReceiver::take_turn(Stream& stream, uint64_t chunk_size, uint64_t message_size)
+{
+  stream.next_bytes_passed += chunk_size;
+  if (stream.next_bytes_passed >= message_size) {
+    ++stream.next_sequence_number;
+    stream.next_bytes_passed = 0;
+  }
+}
+
+ipm::Receiver::duration_t
+StripedReceiver::time_to_next_due(clock_type::time_point now) const
+{
+  auto next_due = duration_t::max();
+  for (auto& stream_pair : m_streams) {
+    auto& held = stream_pair.second.held;
+    if (!held.empty()) {
+      auto remaining = std::max<clock_type::duration>(held.begin()->second.arrival_time + s_reorder_window - now, {});
+      next_due = std::min(next_due, std::chrono::ceil<duration_t>(remaining));
+    }
+  }
+  return next_due;
+}
+
+} // namespace dunedaq::networkmanager
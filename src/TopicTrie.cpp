@@ -0,0 +1,112 @@
+/**
+ *
+ * @file TopicTrie.cpp Wildcard topic patterns and the trie of configured topics they are resolved against
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/TopicTrie.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::networkmanager {
+
+TopicPattern::TopicPattern(std::string pattern)
+  : m_pattern(std::move(pattern))
+  , m_prefix_size(std::min(m_pattern.find(s_wildcard), m_pattern.size()))
+{}
+
+bool
+TopicPattern::matches(std::string_view topic) const noexcept
+{
+  // Greedy matching, which on a mismatch lets the last wildcard take in one more character and retries from
+  // there; earlier wildcards never need to be revisited
+  size_t pattern_pos = 0;
+  size_t topic_pos = 0;
+  size_t last_wildcard = std::string::npos;
+  size_t last_wildcard_topic_pos = 0;
+  while (topic_pos < topic.size()) {
+    if (pattern_pos < m_pattern.size() && m_pattern[pattern_pos] == s_wildcard) {
+      last_wildcard = pattern_pos++;
+      last_wildcard_topic_pos = topic_pos;
+    } else if (pattern_pos < m_pattern.size() && m_pattern[pattern_pos] == topic[topic_pos]) {
+      ++pattern_pos;
+      ++topic_pos;
+    } else if (last_wildcard != std::string::npos) {
+      pattern_pos = last_wildcard + 1;
+      topic_pos = ++last_wildcard_topic_pos;
+    } else {
+      return false;
+    }
+  }
+  while (pattern_pos < m_pattern.size() && m_pattern[pattern_pos] == s_wildcard) {
+    ++pattern_pos;
+  }
+  return pattern_pos == m_pattern.size();
+}
+
+void
+TopicTrie::insert(std::string const& topic)
+{
+  auto node = &m_root;
+  for (auto character : topic) {
+    auto& child = node->children[character];
+    if (child == nullptr) {
+      child = std::make_unique<Node>();
+    }
+    node = child.get();
+  }
+  if (!node->is_topic) {
+    node->is_topic = true;
+    ++m_size;
+  }
+}
+
+void
+TopicTrie::clear()
+{
+  m_root.children.clear();
+  m_root.is_topic = false;
+  m_size = 0;
+}
+
+std::vector<std::string>
+TopicTrie::match(TopicPattern const& pattern) const
+{
+  std::vector<std::string> matches;
+  auto node = &m_root;
+  for (auto character : pattern.prefix()) {
+    auto child_it = node->children.find(character);
+    if (child_it == node->children.end()) {
+      return matches;
+    }
+    node = child_it->second.get();
+  }
+
+  std::string topic(pattern.prefix());
+  collect(*node, topic, pattern, matches);
+  return matches;
+}
+
+void
+TopicTrie::collect(Node const& node,
+                   std::string& topic,
+                   TopicPattern const& pattern,
+                   std::vector<std::string>& matches) const
+{
+  if (node.is_topic && pattern.matches(topic)) {
+    matches.push_back(topic);
+  }
+  for (auto& child_pair : node.children) {
+    topic.push_back(child_pair.first);
+    collect(*child_pair.second, topic, pattern, matches);
+    topic.pop_back();
+  }
+}
+
+} // namespace dunedaq::networkmanager
@@ -0,0 +1,72 @@
+/**
+ *
+ * @file WorkerPool.cpp Persistent threads running short tasks, such as the sends of a publish
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/WorkerPool.hpp"
+
+#include <utility>
+
+namespace dunedaq::networkmanager {
+
+WorkerPool::WorkerPool(size_t max_threads)
+  : m_max_threads(max_threads)
+{}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = true;
+  }
+  m_changed.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void
+WorkerPool::submit(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_tasks.push_back(std::move(task));
+    if (m_idle_threads < m_tasks.size() && m_threads.size() < m_max_threads) {
+      m_threads.emplace_back([this] { thread_loop(); });
+    }
+  }
+  m_changed.notify_one();
+}
+
+size_t
+WorkerPool::thread_count() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_threads.size();
+}
+
+void
+WorkerPool::thread_loop()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  while (true) {
+    ++m_idle_threads;
+    m_changed.wait(lk, [&] { return m_stop || !m_tasks.empty(); });
+    --m_idle_threads;
+    if (m_tasks.empty()) {
+      return;
+    }
+
+    auto task = std::move(m_tasks.front());
+    m_tasks.pop_front();
+    lk.unlock();
+    task();
+    lk.lock();
+  }
+}
+
+} // namespace dunedaq::networkmanager
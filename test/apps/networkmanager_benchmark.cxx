@@ -0,0 +1,413 @@
+/**
+ * @file networkmanager_benchmark.cxx Micro-benchmarks for the NetworkManager hot paths
+ *
+ * Measures throughput and latency percentiles of send_to -> receive_from, send_to -> Listener
+ * callback, get_sender lookups and pub/sub fan-out, over inproc://, TCP loopback and the mem://
+ * in-process transport (which isolates the NetworkManager overhead from that of the sockets), for
+ * a range of message sizes and thread counts. Results are written as JSON so that they can be
+ * compared across releases.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/LatencyHistogram.hpp"
+#include "networkmanager/MemoryTransport.hpp"
+#include "networkmanager/NetworkManager.hpp"
+#include "networkmanager/nwmgr/Structs.hpp"
+
+#include "ipm/PluginInfo.hpp"
+#include "logging/Logging.hpp"
+
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+namespace po = boost::program_options;
+
+namespace {
+
+struct BenchmarkConfig
+{
+  std::vector<size_t> message_sizes;
+  std::vector<size_t> thread_counts;
+  std::vector<std::string> transports;
+  size_t messages_per_thread = 0;
+  size_t lookups_per_thread = 0;
+  size_t subscriber_count = 0;
+  int tcp_base_port = 0;
+};
+
+struct Measurement
+{
+  size_t messages = 0;
+  size_t bytes = 0;
+  double seconds = 0.;
+  LatencyHistogram::Summary latency;
+};
+
+using clock_type = std::chrono::steady_clock;
+
+std::string
+make_address(std::string const& transport, std::string const& name, int port)
+{
+  if (transport == "tcp") {
+    return "tcp://127.0.0.1:" + std::to_string(port);
+  }
+  if (transport == "mem") {
+    return "mem://nwmgr_benchmark_" + name;
+  }
+  return "inproc://nwmgr_benchmark_" + name;
+}
+
+// The send timestamp is carried in the first bytes of the payload
+constexpr size_t s_min_message_size = sizeof(int64_t);
+
+void
+stamp(std::vector<char>& buffer)
+{
+  int64_t now = clock_type::now().time_since_epoch().count();
+  memcpy(buffer.data(), &now, sizeof(now));
+}
+
+void
+record_latency(LatencyHistogram& histogram, std::vector<char> const& data)
+{
+  if (data.size() < s_min_message_size) {
+    return;
+  }
+  int64_t sent;
+  memcpy(&sent, data.data(), sizeof(sent));
+  histogram.record(clock_type::now() - clock_type::time_point(clock_type::duration(sent)));
+}
+
+nlohmann::json
+to_json(std::string const& benchmark,
+        std::string const& transport,
+        size_t message_size,
+        size_t threads,
+        Measurement const& m)
+{
+  nlohmann::json result;
+  result["benchmark"] = benchmark;
+  result["transport"] = transport;
+  result["message_size"] = message_size;
+  result["threads"] = threads;
+  result["messages"] = m.messages;
+  result["seconds"] = m.seconds;
+  result["messages_per_second"] = m.seconds > 0. ? m.messages / m.seconds : 0.;
+  result["megabytes_per_second"] = m.seconds > 0. ? m.bytes / m.seconds / 1e6 : 0.;
+  result["latency_us"] = { { "mean", m.latency.mean / 1000. }, { "p50", m.latency.p50 / 1000. },
+                           { "p90", m.latency.p90 / 1000. },   { "p99", m.latency.p99 / 1000. },
+                           { "p999", m.latency.p999 / 1000. }, { "max", m.latency.max / 1000. } };
+  return result;
+}
+
+void
+run_senders(std::string const& connection, size_t threads, size_t messages_per_thread, size_t message_size)
+{
+  std::vector<std::thread> senders;
+  for (size_t idx = 0; idx < threads; ++idx) {
+    senders.emplace_back([&]() {
+      std::vector<char> buffer(message_size, 'x');
+      for (size_t msg = 0; msg < messages_per_thread; ++msg) {
+        stamp(buffer);
+        NetworkManager::get().send_to(connection, buffer.data(), buffer.size(), ipm::Sender::s_block);
+      }
+    });
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+}
+
+Measurement
+bench_send_receive(BenchmarkConfig const& conf, std::string const& transport, size_t message_size, size_t threads)
+{
+  NetworkManager::get().configure(
+    { { "bench_sendrecv", make_address(transport, "sendrecv", conf.tcp_base_port), {} } });
+
+  LatencyHistogram histogram;
+  size_t expected = threads * conf.messages_per_thread;
+  Measurement m;
+
+  // Open the receiver before timing, so that the first message does not pay for the connection
+  NetworkManager::get().get_receiver("bench_sendrecv");
+  auto start = clock_type::now();
+  std::thread receiver([&]() {
+    while (m.messages < expected) {
+      try {
+        auto response = NetworkManager::get().receive_from("bench_sendrecv", std::chrono::milliseconds(1000));
+        record_latency(histogram, response.data);
+        m.bytes += response.data.size();
+        ++m.messages;
+      } catch (ipm::ReceiveTimeoutExpired const&) {
+        TLOG() << "Timed out waiting for messages, " << m.messages << " of " << expected << " received";
+        break;
+      }
+    }
+  });
+  run_senders("bench_sendrecv", threads, conf.messages_per_thread, message_size);
+  receiver.join();
+  m.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  m.latency = histogram.collect_and_reset();
+
+  NetworkManager::get().reset();
+  return m;
+}
+
+Measurement
+bench_send_listener(BenchmarkConfig const& conf, std::string const& transport, size_t message_size, size_t threads)
+{
+  NetworkManager::get().configure(
+    { { "bench_listener", make_address(transport, "listener", conf.tcp_base_port + 1), {} } });
+
+  LatencyHistogram histogram;
+  std::atomic<size_t> received{ 0 };
+  std::atomic<size_t> received_bytes{ 0 };
+  size_t expected = threads * conf.messages_per_thread;
+
+  NetworkManager::get().start_listening("bench_listener");
+  NetworkManager::get().register_callback("bench_listener", [&](ipm::Receiver::Response response) {
+    record_latency(histogram, response.data);
+    received_bytes += response.data.size();
+    ++received;
+  });
+
+  auto start = clock_type::now();
+  run_senders("bench_listener", threads, conf.messages_per_thread, message_size);
+  auto deadline = clock_type::now() + std::chrono::seconds(10);
+  while (received.load() < expected && clock_type::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  Measurement m;
+  m.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  m.messages = received.load();
+  m.bytes = received_bytes.load();
+  m.latency = histogram.collect_and_reset();
+
+  NetworkManager::get().reset();
+  return m;
+}
+
+Measurement
+bench_get_sender(BenchmarkConfig const& conf, std::string const& transport, size_t threads)
+{
+  NetworkManager::get().configure(
+    { { "bench_lookup", make_address(transport, "lookup", conf.tcp_base_port + 2), {} } });
+  NetworkManager::get().get_sender("bench_lookup");
+
+  std::vector<LatencyHistogram::Summary> summaries(threads);
+  auto start = clock_type::now();
+  std::vector<std::thread> workers;
+  for (size_t idx = 0; idx < threads; ++idx) {
+    workers.emplace_back([&, idx]() {
+      LatencyHistogram histogram;
+      for (size_t lookup = 0; lookup < conf.lookups_per_thread; ++lookup) {
+        auto before = clock_type::now();
+        auto sender = NetworkManager::get().get_sender("bench_lookup");
+        histogram.record(clock_type::now() - before);
+      }
+      summaries[idx] = histogram.collect_and_reset();
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  Measurement m;
+  m.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  m.messages = threads * conf.lookups_per_thread;
+  // Report the slowest thread's percentiles
+  for (auto& summary : summaries) {
+    m.latency.count += summary.count;
+    m.latency.mean = std::max(m.latency.mean, summary.mean);
+    m.latency.p50 = std::max(m.latency.p50, summary.p50);
+    m.latency.p90 = std::max(m.latency.p90, summary.p90);
+    m.latency.p99 = std::max(m.latency.p99, summary.p99);
+    m.latency.p999 = std::max(m.latency.p999, summary.p999);
+    m.latency.max = std::max(m.latency.max, summary.max);
+  }
+
+  NetworkManager::get().reset();
+  return m;
+}
+
+Measurement
+bench_fanout(BenchmarkConfig const& conf, std::string const& transport, size_t message_size, size_t threads)
+{
+  NetworkManager::get().configure(
+    { { "bench_publisher", make_address(transport, "fanout", conf.tcp_base_port + 3), { "bench_topic" } } });
+  NetworkManager::get().start_publisher("bench_publisher");
+
+  // Independent subscribers, as they would be in separate applications; mem:// channels only exist in-process,
+  // so those subscribers are the in-process ones NetworkManager would create
+  std::vector<std::shared_ptr<ipm::Subscriber>> subscribers;
+  for (size_t idx = 0; idx < conf.subscriber_count; ++idx) {
+    std::shared_ptr<ipm::Subscriber> subscriber;
+    if (transport == "mem") {
+      subscriber = std::make_shared<MemorySubscriber>();
+    } else {
+      subscriber = std::dynamic_pointer_cast<ipm::Subscriber>(
+        ipm::make_ipm_receiver(ipm::get_recommended_plugin_name(ipm::IpmPluginType::Subscriber)));
+    }
+    subscriber->connect_for_receives(
+      { { "connection_strings", NetworkManager::get().get_connection_strings("bench_topic") } });
+    subscriber->subscribe("bench_topic");
+    subscribers.push_back(subscriber);
+  }
+  // Give the subscriptions time to propagate to the publisher
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  size_t expected = threads * conf.messages_per_thread;
+  std::vector<LatencyHistogram::Summary> summaries(subscribers.size());
+  std::vector<size_t> received(subscribers.size(), 0);
+
+  auto start = clock_type::now();
+  std::vector<std::thread> receivers;
+  for (size_t idx = 0; idx < subscribers.size(); ++idx) {
+    receivers.emplace_back([&, idx]() {
+      LatencyHistogram histogram;
+      while (received[idx] < expected) {
+        try {
+          auto response = subscribers[idx]->receive(std::chrono::milliseconds(1000));
+          record_latency(histogram, response.data);
+          ++received[idx];
+        } catch (ipm::ReceiveTimeoutExpired const&) {
+          break;
+        }
+      }
+      summaries[idx] = histogram.collect_and_reset();
+    });
+  }
+
+  std::vector<std::thread> senders;
+  for (size_t idx = 0; idx < threads; ++idx) {
+    senders.emplace_back([&]() {
+      std::vector<char> buffer(message_size, 'x');
+      for (size_t msg = 0; msg < conf.messages_per_thread; ++msg) {
+        stamp(buffer);
+        NetworkManager::get().send_to(
+          "bench_publisher", buffer.data(), buffer.size(), ipm::Sender::s_block, "bench_topic");
+      }
+    });
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+  for (auto& receiver : receivers) {
+    receiver.join();
+  }
+
+  Measurement m;
+  m.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  for (size_t idx = 0; idx < subscribers.size(); ++idx) {
+    m.messages += received[idx];
+    m.latency.count += summaries[idx].count;
+    m.latency.mean = std::max(m.latency.mean, summaries[idx].mean);
+    m.latency.p50 = std::max(m.latency.p50, summaries[idx].p50);
+    m.latency.p90 = std::max(m.latency.p90, summaries[idx].p90);
+    m.latency.p99 = std::max(m.latency.p99, summaries[idx].p99);
+    m.latency.p999 = std::max(m.latency.p999, summaries[idx].p999);
+    m.latency.max = std::max(m.latency.max, summaries[idx].max);
+  }
+  m.bytes = m.messages * message_size;
+
+  subscribers.clear();
+  NetworkManager::get().reset();
+  return m;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  BenchmarkConfig conf;
+  std::string output_file;
+
+  po::options_description desc("Micro-benchmarks for the NetworkManager hot paths");
+  desc.add_options()("help,h", "Print this help message")(
+    "output,o", po::value<std::string>(&output_file)->default_value("networkmanager_benchmark.json"), "JSON result file")(
+    "sizes,s",
+    po::value<std::vector<size_t>>(&conf.message_sizes)->multitoken()->default_value({ 64, 4096, 1048576 }, "64 4096 1048576"),
+    "Message sizes in bytes")(
+    "threads,t",
+    po::value<std::vector<size_t>>(&conf.thread_counts)->multitoken()->default_value({ 1, 4 }, "1 4"),
+    "Numbers of sending threads")(
+    "transports",
+    po::value<std::vector<std::string>>(&conf.transports)
+      ->multitoken()
+      ->default_value({ "mem", "inproc", "tcp" }, "mem inproc tcp"),
+    "Transports to test (mem, inproc, tcp)")(
+    "messages,n", po::value<size_t>(&conf.messages_per_thread)->default_value(10000), "Messages per sending thread")(
+    "lookups", po::value<size_t>(&conf.lookups_per_thread)->default_value(1000000), "get_sender calls per thread")(
+    "subscribers", po::value<size_t>(&conf.subscriber_count)->default_value(4), "Subscribers for the fan-out benchmark")(
+    "port", po::value<int>(&conf.tcp_base_port)->default_value(25600), "First TCP port to use on 127.0.0.1");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (std::exception const& e) {
+    std::cerr << "Bad command line: " << e.what() << std::endl << desc << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  nlohmann::json results = nlohmann::json::array();
+  auto report = [&](nlohmann::json const& result) {
+    TLOG() << result.dump();
+    results.push_back(result);
+  };
+
+  for (auto& transport : conf.transports) {
+    for (auto threads : conf.thread_counts) {
+      report(to_json("get_sender", transport, 0, threads, bench_get_sender(conf, transport, threads)));
+
+      for (auto size : conf.message_sizes) {
+        size = std::max(size, s_min_message_size);
+        report(to_json("send_receive", transport, size, threads, bench_send_receive(conf, transport, size, threads)));
+        report(to_json("send_listener", transport, size, threads, bench_send_listener(conf, transport, size, threads)));
+        report(to_json("pubsub_fanout", transport, size, threads, bench_fanout(conf, transport, size, threads)));
+      }
+    }
+  }
+
+  nlohmann::json output;
+  output["benchmark_suite"] = "networkmanager_benchmark";
+  output["time"] = std::chrono::duration_cast<std::chrono::seconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+  output["hardware_concurrency"] = std::thread::hardware_concurrency();
+  output["subscribers"] = conf.subscriber_count;
+  output["results"] = results;
+
+  std::ofstream out(output_file);
+  out << output.dump(2) << std::endl;
+  TLOG() << "Wrote " << results.size() << " results to " << output_file;
+
+  return 0;
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,211 @@
+/**
+ * @file networkmanager_scaling_benchmark.cxx Connection-scaling benchmark for NetworkManager
+ *
+ * For increasing numbers of connections and topics, times configure(), bulk start_listening and
+ * subscribe, the first message on a connection (which lazily creates its sender and receiver) and
+ * reset(), recording the thread count and resident memory after each step.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/LatencyHistogram.hpp"
+#include "networkmanager/NetworkManager.hpp"
+#include "networkmanager/nwmgr/Structs.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+namespace po = boost::program_options;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct ProcessStatus
+{
+  size_t threads = 0;
+  size_t rss_kb = 0;
+};
+
+ProcessStatus
+read_process_status()
+{
+  ProcessStatus status;
+  std::ifstream proc_status("/proc/self/status");
+  std::string key;
+  while (proc_status >> key) {
+    if (key == "Threads:") {
+      proc_status >> status.threads;
+    } else if (key == "VmRSS:") {
+      proc_status >> status.rss_kb;
+    }
+    proc_status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return status;
+}
+
+std::string
+make_address(std::string const& transport, std::string const& name, int port)
+{
+  if (transport == "tcp") {
+    return "tcp://127.0.0.1:" + std::to_string(port);
+  }
+  return "inproc://nwmgr_scaling_" + name;
+}
+
+template<typename F>
+nlohmann::json
+timed_step(std::string const& step, F&& f)
+{
+  auto start = clock_type::now();
+  f();
+  auto seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  auto status = read_process_status();
+
+  nlohmann::json result;
+  result["step"] = step;
+  result["seconds"] = seconds;
+  result["threads"] = status.threads;
+  result["rss_kb"] = status.rss_kb;
+  TLOG() << step << ": " << seconds << " s, " << status.threads << " threads, " << status.rss_kb << " kB RSS";
+  return result;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  std::vector<size_t> connection_counts;
+  std::string transport;
+  std::string output_file;
+  size_t max_listeners = 0;
+  size_t first_message_samples = 0;
+  int tcp_base_port = 0;
+
+  po::options_description desc("Connection-scaling benchmark for NetworkManager");
+  desc.add_options()("help,h", "Print this help message")(
+    "output,o",
+    po::value<std::string>(&output_file)->default_value("networkmanager_scaling_benchmark.json"),
+    "JSON result file")(
+    "connections,c",
+    po::value<std::vector<size_t>>(&connection_counts)
+      ->multitoken()
+      ->default_value({ 10, 100, 1000, 10000 }, "10 100 1000 10000"),
+    "Numbers of connections (and of topics) to configure")(
+    "transport", po::value<std::string>(&transport)->default_value("inproc"), "Transport to use (inproc, tcp)")(
+    "max-listeners",
+    po::value<size_t>(&max_listeners)->default_value(10000),
+    "Maximum number of connections and topics to listen on; each Listener is a thread")(
+    "first-message-samples",
+    po::value<size_t>(&first_message_samples)->default_value(100),
+    "Number of connections on which to time the first message")(
+    "port", po::value<int>(&tcp_base_port)->default_value(30000), "First TCP port to use on 127.0.0.1");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (std::exception const& e) {
+    std::cerr << "Bad command line: " << e.what() << std::endl << desc << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  nlohmann::json results = nlohmann::json::array();
+  auto baseline = read_process_status();
+
+  for (auto count : connection_counts) {
+    TLOG() << "Scaling test with " << count << " connections and topics";
+
+    // count point-to-point connections, plus count publishers each declaring one topic
+    nwmgr::Connections connections;
+    for (size_t idx = 0; idx < count; ++idx) {
+      connections.push_back({ "conn_" + std::to_string(idx),
+                              make_address(transport, "conn_" + std::to_string(idx), tcp_base_port + 2 * idx),
+                              {} });
+      connections.push_back({ "pub_" + std::to_string(idx),
+                              make_address(transport, "pub_" + std::to_string(idx), tcp_base_port + 2 * idx + 1),
+                              { "topic_" + std::to_string(idx) } });
+    }
+    auto listeners = std::min(count, max_listeners);
+    auto samples = std::min(count, first_message_samples);
+
+    nlohmann::json result;
+    result["connections"] = count;
+    result["topics"] = count;
+    result["listeners"] = listeners;
+    result["baseline_threads"] = baseline.threads;
+    result["baseline_rss_kb"] = baseline.rss_kb;
+
+    nlohmann::json steps = nlohmann::json::array();
+    steps.push_back(timed_step("configure", [&]() { NetworkManager::get().configure(connections); }));
+
+    // Time a send/receive pair on connections that have neither a sender nor a receiver yet
+    LatencyHistogram first_message;
+    steps.push_back(timed_step("first_message", [&]() {
+      std::string message = "first message";
+      for (size_t idx = 0; idx < samples; ++idx) {
+        auto name = "conn_" + std::to_string(idx);
+        auto start = clock_type::now();
+        NetworkManager::get().send_to(name, message.c_str(), message.size(), ipm::Sender::s_block);
+        NetworkManager::get().receive_from(name, std::chrono::seconds(10));
+        first_message.record(clock_type::now() - start);
+      }
+    }));
+    auto summary = first_message.collect_and_reset();
+    steps.back()["latency_us"] = { { "mean", summary.mean / 1000. }, { "p50", summary.p50 / 1000. },
+                                   { "p99", summary.p99 / 1000. },   { "max", summary.max / 1000. } };
+
+    steps.push_back(timed_step("start_listening", [&]() {
+      for (size_t idx = 0; idx < listeners; ++idx) {
+        NetworkManager::get().start_listening("conn_" + std::to_string(idx));
+      }
+    }));
+    steps.push_back(timed_step("subscribe", [&]() {
+      for (size_t idx = 0; idx < listeners; ++idx) {
+        NetworkManager::get().subscribe("topic_" + std::to_string(idx));
+      }
+    }));
+    steps.push_back(timed_step("reset", [&]() { NetworkManager::get().reset(); }));
+
+    result["steps"] = steps;
+    results.push_back(result);
+  }
+
+  nlohmann::json output;
+  output["benchmark_suite"] = "networkmanager_scaling_benchmark";
+  output["time"] = std::chrono::duration_cast<std::chrono::seconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+  output["transport"] = transport;
+  output["results"] = results;
+
+  std::ofstream out(output_file);
+  out << output.dump(2) << std::endl;
+  TLOG() << "Wrote " << results.size() << " results to " << output_file;
+
+  return 0;
+}
+
+#pragma GCC diagnostic pop
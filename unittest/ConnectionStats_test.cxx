@@ -0,0 +1,199 @@
+/**
+ * @file ConnectionStats_test.cxx ConnectionStats class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/ConnectionStats.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE ConnectionStats_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <array>
+#include <chrono>
+#include <thread>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(ConnectionStats_test)
+
+BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
+{
+  BOOST_REQUIRE(!std::is_copy_constructible_v<ConnectionStats>);
+  BOOST_REQUIRE(!std::is_copy_assignable_v<ConnectionStats>);
+  BOOST_REQUIRE(!std::is_move_constructible_v<ConnectionStats>);
+  BOOST_REQUIRE(!std::is_move_assignable_v<ConnectionStats>);
+}
+
+BOOST_AUTO_TEST_CASE(CacheLinePadding)
+{
+  BOOST_REQUIRE_EQUAL(alignof(DirectionCounters), s_cache_line_size);
+  BOOST_REQUIRE(sizeof(ConnectionStats) >= 2 * s_cache_line_size);
+}
+
+BOOST_AUTO_TEST_CASE(Counters)
+{
+  ConnectionStats stats;
+  connectioninfo::Info info;
+
+  stats.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.sent_bytes, 0);
+  BOOST_REQUIRE_EQUAL(info.received_messages, 0);
+
+  stats.record_send(10);
+  stats.record_send(20);
+  stats.record_receive(5);
+
+  stats.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.sent_bytes, 30);
+  BOOST_REQUIRE_EQUAL(info.sent_messages, 2);
+  BOOST_REQUIRE_EQUAL(info.received_bytes, 5);
+  BOOST_REQUIRE_EQUAL(info.received_messages, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Rates)
+{
+  ConnectionStats stats;
+  connectioninfo::Info info;
+  stats.fill_info(info);
+
+  stats.record_send(1000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  stats.fill_info(info);
+
+  BOOST_REQUIRE(info.sent_message_rate > 0.);
+  BOOST_REQUIRE(info.sent_byte_rate > 0.);
+  BOOST_REQUIRE(info.sent_byte_rate < 1000. / 0.1 + 1.);
+  BOOST_REQUIRE_EQUAL(info.received_byte_rate, 0.);
+
+  // No new traffic since the previous call
+  stats.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.sent_bytes, 1000);
+  BOOST_REQUIRE_EQUAL(info.sent_byte_rate, 0.);
+}
+
+BOOST_AUTO_TEST_CASE(ListenerGauges)
+{
+  ConnectionStats stats;
+  connectioninfo::Info info;
+  stats.fill_info(info);
+  BOOST_REQUIRE(info.seconds_since_last_receive < 0.);
+  BOOST_REQUIRE_EQUAL(info.seconds_in_callback, 0.);
+
+  auto& activity = stats.listener_activity();
+  auto start = std::chrono::steady_clock::now();
+  activity.last_receive_ns = ListenerActivity::to_ns(start);
+  activity.callback_start_ns = ListenerActivity::to_ns(start);
+  activity.callback_overruns = 3;
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  stats.fill_info(info);
+  BOOST_REQUIRE(info.seconds_since_last_receive >= 0.05);
+  BOOST_REQUIRE(info.seconds_in_callback >= 0.05);
+  BOOST_REQUIRE_EQUAL(info.callback_overruns, 3);
+}
+
+BOOST_AUTO_TEST_CASE(ChangeDetection)
+{
+  ConnectionStats stats;
+  connectioninfo::Info info;
+  stats.fill_info(info);
+  auto now = std::chrono::steady_clock::now();
+  BOOST_REQUIRE(!stats.changed_since_last_info(now));
+
+  stats.record_receive(10);
+  BOOST_REQUIRE(stats.changed_since_last_info(now));
+  stats.fill_info(info);
+
+  // The non-zero rates just reported still have to be brought back to zero
+  BOOST_REQUIRE(stats.changed_since_last_info(now));
+  stats.fill_info(info);
+  BOOST_REQUIRE(!stats.changed_since_last_info(now));
+
+  // Idle connections are still reported from time to time
+  auto later = std::chrono::steady_clock::now() + ConnectionStats::s_idle_report_interval;
+  BOOST_REQUIRE(stats.changed_since_last_info(later));
+
+  stats.listener_activity().callback_start_ns = ListenerActivity::to_ns(now);
+  BOOST_REQUIRE(stats.changed_since_last_info(now));
+}
+
+BOOST_AUTO_TEST_CASE(Totals)
+{
+  ConnectionStats first;
+  ConnectionStats second;
+  first.record_send(10);
+  second.record_send(20);
+  second.record_receive(5);
+  second.sender_health().failovers = 2;
+
+  connectioninfo::Info totals;
+  first.add_to_totals(totals);
+  second.add_to_totals(totals);
+  BOOST_REQUIRE_EQUAL(totals.sent_bytes, 30);
+  BOOST_REQUIRE_EQUAL(totals.sent_messages, 2);
+  BOOST_REQUIRE_EQUAL(totals.received_bytes, 5);
+  BOOST_REQUIRE_EQUAL(totals.failovers, 2);
+
+  connectioninfo::Info last_totals;
+  ConnectionStats::fill_rates(totals, last_totals, 2.);
+  BOOST_REQUIRE_EQUAL(totals.sent_byte_rate, 15.);
+  BOOST_REQUIRE_EQUAL(totals.sent_message_rate, 1.);
+}
+
+BOOST_AUTO_TEST_CASE(BusyPoll)
+{
+  ConnectionStats stats;
+  auto& activity = stats.listener_activity();
+  activity.busy_poll_hits = 3;
+  activity.busy_poll_misses = 1;
+  activity.busy_poll_ns = 2000;
+
+  connectioninfo::Info info;
+  stats.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.busy_poll_hits, 3);
+  BOOST_REQUIRE_EQUAL(info.busy_poll_misses, 1);
+  BOOST_REQUIRE_EQUAL(info.busy_poll_us, 2.);
+  BOOST_REQUIRE_EQUAL(info.busy_poll_hit_ratio, 0.75);
+  BOOST_REQUIRE(!stats.changed_since_last_info(std::chrono::steady_clock::now()));
+
+  // The hit ratio covers the periods since the previous report
+  activity.busy_poll_misses = 2;
+  BOOST_REQUIRE(stats.changed_since_last_info(std::chrono::steady_clock::now()));
+  stats.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.busy_poll_hit_ratio, 0.);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentUpdates)
+{
+  ConnectionStats stats;
+  const int thread_count = 10;
+  const int updates_per_thread = 10000;
+
+  std::array<std::thread, thread_count> threads;
+  for (int idx = 0; idx < thread_count; ++idx) {
+    threads[idx] = std::thread([&]() {
+      for (int i = 0; i < updates_per_thread; ++i) {
+        stats.record_send(2);
+        stats.record_receive(1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  connectioninfo::Info info;
+  stats.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.sent_messages, thread_count * updates_per_thread);
+  BOOST_REQUIRE_EQUAL(info.sent_bytes, 2 * thread_count * updates_per_thread);
+  BOOST_REQUIRE_EQUAL(info.received_messages, thread_count * updates_per_thread);
+  BOOST_REQUIRE_EQUAL(info.received_bytes, thread_count * updates_per_thread);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
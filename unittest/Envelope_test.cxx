@@ -0,0 +1,203 @@
+/**
+ * @file Envelope_test.cxx EnvelopeHeader, SequenceTracker and Reassembler Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Envelope.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE Envelope_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(Envelope_test)
+
+BOOST_AUTO_TEST_CASE(HeaderRoundTrip)
+{
+  EnvelopeHeader header;
+  header.sequence_number = 12345;
+  header.send_time_ns = 9876543210;
+  header.sender_id = 0xdeadbeefcafef00d;
+
+  std::vector<char> buffer(EnvelopeHeader::s_size + 3, 'x');
+  header.write(buffer.data());
+
+  EnvelopeHeader read_header;
+  BOOST_REQUIRE(read_header.read(buffer.data(), buffer.size()));
+  BOOST_REQUIRE_EQUAL(read_header.sequence_number, header.sequence_number);
+  BOOST_REQUIRE_EQUAL(read_header.send_time_ns, header.send_time_ns);
+  BOOST_REQUIRE_EQUAL(read_header.sender_id, header.sender_id);
+  BOOST_REQUIRE_EQUAL(buffer[EnvelopeHeader::s_size], 'x');
+}
+
+BOOST_AUTO_TEST_CASE(InvalidHeader)
+{
+  EnvelopeHeader header;
+  std::vector<char> buffer(EnvelopeHeader::s_size);
+  header.write(buffer.data());
+
+  EnvelopeHeader read_header;
+  BOOST_REQUIRE(!read_header.read(buffer.data(), EnvelopeHeader::s_size - 1));
+
+  std::string not_an_envelope = "this is a plain message without any envelope";
+  BOOST_REQUIRE(!read_header.read(not_an_envelope.c_str(), not_an_envelope.size()));
+}
+
+BOOST_AUTO_TEST_CASE(SequenceTracking)
+{
+  SequenceTracker tracker;
+
+  // First message only establishes the starting point
+  auto result = tracker.update(1, "", 10);
+  BOOST_REQUIRE_EQUAL(result.missing, 0);
+  BOOST_REQUIRE(!result.out_of_order);
+
+  result = tracker.update(1, "", 11);
+  BOOST_REQUIRE_EQUAL(result.missing, 0);
+  BOOST_REQUIRE(!result.out_of_order);
+
+  result = tracker.update(1, "", 15);
+  BOOST_REQUIRE_EQUAL(result.missing, 3);
+  BOOST_REQUIRE(!result.out_of_order);
+
+  // A late message fills its gap, once
+  result = tracker.update(1, "", 13);
+  BOOST_REQUIRE_EQUAL(result.missing, 0);
+  BOOST_REQUIRE(result.out_of_order);
+  BOOST_REQUIRE(result.recovered);
+  result = tracker.update(1, "", 13);
+  BOOST_REQUIRE(result.out_of_order);
+  BOOST_REQUIRE(!result.recovered);
+  for (uint64_t sequence_number : { 12, 14 }) {
+    BOOST_REQUIRE(tracker.update(1, "", sequence_number).recovered);
+  }
+
+  result = tracker.update(1, "", 15);
+  BOOST_REQUIRE(result.out_of_order);
+  BOOST_REQUIRE(!result.recovered);
+
+  // Other senders and streams are numbered independently
+  result = tracker.update(2, "", 0);
+  BOOST_REQUIRE_EQUAL(result.missing, 0);
+  result = tracker.update(1, "topic", 0);
+  BOOST_REQUIRE_EQUAL(result.missing, 0);
+  result = tracker.update(1, "topic", 2);
+  BOOST_REQUIRE_EQUAL(result.missing, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GapLimit)
+{
+  SequenceTracker tracker;
+  tracker.update(1, "", 0);
+  for (uint64_t gap = 0; gap <= SequenceTracker::s_max_gaps; ++gap) {
+    BOOST_REQUIRE_EQUAL(tracker.update(1, "", 2 * gap + 2).missing, 1);
+  }
+
+  // The oldest gap has been given up, the others are still remembered
+  BOOST_REQUIRE(!tracker.update(1, "", 1).recovered);
+  BOOST_REQUIRE(tracker.update(1, "", 3).recovered);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkHeaderRoundTrip)
+{
+  ChunkHeader chunk;
+  chunk.message_size = 300000000;
+  chunk.offset = 1048576;
+
+  std::vector<char> buffer(ChunkHeader::s_size);
+  chunk.write(buffer.data());
+
+  ChunkHeader read_back;
+  BOOST_REQUIRE(read_back.read(buffer.data(), buffer.size()));
+  BOOST_REQUIRE_EQUAL(read_back.message_size, chunk.message_size);
+  BOOST_REQUIRE_EQUAL(read_back.offset, chunk.offset);
+  BOOST_REQUIRE(!read_back.read(buffer.data(), ChunkHeader::s_size - 1));
+}
+
+BOOST_AUTO_TEST_CASE(Reassembly)
+{
+  Reassembler reassembler;
+  reassembler.set_max_message_size(1000);
+  std::string first = "a large message";
+  std::string second = "another one";
+  std::vector<char> data;
+
+  // Chunks of two messages, interleaved and out of order
+  ChunkHeader chunk;
+  chunk.message_size = first.size();
+  chunk.offset = 8;
+  auto result = reassembler.add(1, "", 10, chunk, first.data() + 8, first.size() - 8, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Incomplete);
+  BOOST_REQUIRE(result.first_chunk);
+
+  ChunkHeader other_chunk;
+  other_chunk.message_size = second.size();
+  result = reassembler.add(1, "", 11, other_chunk, second.data(), 4, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Incomplete);
+  BOOST_REQUIRE_EQUAL(reassembler.pending(), 2);
+
+  // Repeated chunks do not count twice, and overlapping ones are dropped
+  result = reassembler.add(1, "", 10, chunk, first.data() + 8, first.size() - 8, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Incomplete);
+  result = reassembler.add(1, "", 10, chunk, first.data() + 8, 4, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Invalid);
+  chunk.offset = 4;
+  result = reassembler.add(1, "", 10, chunk, first.data() + 4, 8, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Invalid);
+
+  chunk.offset = 0;
+  result = reassembler.add(1, "", 10, chunk, first.data(), 8, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Complete);
+  BOOST_REQUIRE(!result.first_chunk);
+  BOOST_REQUIRE_EQUAL(std::string(data.begin(), data.end()), first);
+
+  // A chunk reaching past the end of its message is dropped
+  other_chunk.offset = 4;
+  result = reassembler.add(1, "", 11, other_chunk, second.data() + 4, second.size(), data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Invalid);
+  result = reassembler.add(1, "", 11, other_chunk, second.data() + 4, second.size() - 4, data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Complete);
+  BOOST_REQUIRE_EQUAL(std::string(data.begin(), data.end()), second);
+  BOOST_REQUIRE_EQUAL(reassembler.pending(), 0);
+
+  // A message larger than the maximum is not allocated, whatever its header says
+  ChunkHeader huge_chunk;
+  huge_chunk.message_size = 1ULL << 62;
+  result = reassembler.add(1, "", 12, huge_chunk, first.data(), first.size(), data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Invalid);
+  huge_chunk.message_size = 1001;
+  result = reassembler.add(1, "", 12, huge_chunk, first.data(), first.size(), data);
+  BOOST_REQUIRE(result.status == Reassembler::Status::Invalid);
+  BOOST_REQUIRE_EQUAL(reassembler.pending(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(AbandonedReassembly)
+{
+  Reassembler reassembler;
+  reassembler.set_max_message_size(1000);
+  std::string message = "a message which never completes";
+  std::vector<char> data;
+  ChunkHeader chunk;
+  chunk.message_size = message.size();
+
+  auto start = std::chrono::steady_clock::now();
+  reassembler.add(1, "", 1, chunk, message.data(), 4, data, start);
+  BOOST_REQUIRE_EQUAL(reassembler.abandoned_messages(), 0);
+
+  // Stale messages are given up when another message starts
+  reassembler.add(1, "", 2, chunk, message.data(), 4, data, start + Reassembler::s_timeout);
+  BOOST_REQUIRE_EQUAL(reassembler.abandoned_messages(), 1);
+  BOOST_REQUIRE_EQUAL(reassembler.pending(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+/**
+ * @file InstrumentedMutex_test.cxx InstrumentedMutex class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/InstrumentedMutex.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE InstrumentedMutex_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(InstrumentedMutex_test)
+
+BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
+{
+  BOOST_REQUIRE(!std::is_copy_constructible_v<InstrumentedMutex>);
+  BOOST_REQUIRE(!std::is_copy_assignable_v<InstrumentedMutex>);
+  BOOST_REQUIRE(!std::is_move_constructible_v<InstrumentedMutex>);
+  BOOST_REQUIRE(!std::is_move_assignable_v<InstrumentedMutex>);
+}
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  InstrumentedMutex::set_enabled(false);
+  InstrumentedMutex mutex;
+  {
+    std::lock_guard<InstrumentedMutex> lk(mutex);
+  }
+  BOOST_REQUIRE(mutex.try_lock());
+  mutex.unlock();
+
+  dunedaq::networkmanager::connectioninfo::LockInfo info;
+  mutex.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.acquisitions, 0);
+  BOOST_REQUIRE_EQUAL(info.hold_us, 0.);
+}
+
+BOOST_AUTO_TEST_CASE(Contention)
+{
+  InstrumentedMutex::set_enabled(true);
+  InstrumentedMutex mutex;
+
+  std::unique_lock<InstrumentedMutex> lk(mutex);
+  std::thread waiter([&]() { std::lock_guard<InstrumentedMutex> waiter_lk(mutex); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  lk.unlock();
+  waiter.join();
+
+  dunedaq::networkmanager::connectioninfo::LockInfo info;
+  mutex.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.acquisitions, 2);
+  BOOST_REQUIRE_EQUAL(info.contended_acquisitions, 1);
+  BOOST_REQUIRE_GT(info.max_wait_us, 10000.);
+  BOOST_REQUIRE_GE(info.wait_us, info.max_wait_us);
+  BOOST_REQUIRE_GT(info.max_hold_us, 10000.);
+  BOOST_REQUIRE_GE(info.hold_us, info.max_hold_us);
+
+  // Each report covers the interval since the previous one
+  mutex.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.acquisitions, 0);
+  BOOST_REQUIRE_EQUAL(info.max_wait_us, 0.);
+
+  InstrumentedMutex::set_enabled(false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,226 @@
+/**
+ * @file KeyedDispatcher_test.cxx KeyedDispatcher class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/KeyedDispatcher.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE KeyedDispatcher_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+
+namespace {
+ipm::Receiver::Response
+make_response(uint64_t key, uint64_t sequence_number)
+{
+  ipm::Receiver::Response response;
+  response.data.resize(2 * sizeof(uint64_t));
+  memcpy(response.data.data(), &key, sizeof(key));
+  memcpy(response.data.data() + sizeof(key), &sequence_number, sizeof(sequence_number));
+  return response;
+}
+
+uint64_t
+read_word(ipm::Receiver::Response const& response, size_t index)
+{
+  uint64_t word = 0;
+  memcpy(&word, response.data.data() + index * sizeof(word), sizeof(word));
+  return word;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(KeyedDispatcher_test)
+
+BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
+{
+  BOOST_REQUIRE(!std::is_copy_constructible_v<KeyedDispatcher>);
+  BOOST_REQUIRE(!std::is_copy_assignable_v<KeyedDispatcher>);
+  BOOST_REQUIRE(!std::is_move_constructible_v<KeyedDispatcher>);
+  BOOST_REQUIRE(!std::is_move_assignable_v<KeyedDispatcher>);
+}
+
+BOOST_AUTO_TEST_CASE(WorkerSelection)
+{
+  KeyedDispatcher dispatcher(
+    [](ipm::Receiver::Response) {}, [](ipm::Receiver::Response const&) { return 0; }, 4, "", nullptr);
+  BOOST_REQUIRE_EQUAL(dispatcher.worker_count(), 4);
+
+  std::set<size_t> workers;
+  for (uint64_t key = 0; key < 1000; key += 4) {
+    BOOST_REQUIRE_EQUAL(dispatcher.worker_for(key), dispatcher.worker_for(key));
+    workers.insert(dispatcher.worker_for(key));
+  }
+  BOOST_REQUIRE_EQUAL(workers.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(PerKeyOrdering)
+{
+  const uint64_t key_count = 16;
+  const uint64_t messages_per_key = 500;
+
+  std::mutex mutex;
+  std::map<uint64_t, std::vector<uint64_t>> received;
+  std::set<std::thread::id> threads;
+  {
+    KeyedDispatcher dispatcher(
+      [&](ipm::Receiver::Response response) {
+        std::lock_guard<std::mutex> lk(mutex);
+        received[read_word(response, 0)].push_back(read_word(response, 1));
+        threads.insert(std::this_thread::get_id());
+      },
+      [](ipm::Receiver::Response const& response) { return read_word(response, 0); },
+      4,
+      "test",
+      nullptr);
+
+    for (uint64_t sequence_number = 0; sequence_number < messages_per_key; ++sequence_number) {
+      for (uint64_t key = 0; key < key_count; ++key) {
+        dispatcher.dispatch(make_response(key, sequence_number), std::chrono::steady_clock::now());
+      }
+    }
+    // Destruction processes everything already dispatched
+  }
+
+  BOOST_REQUIRE_EQUAL(received.size(), key_count);
+  for (auto& key_pair : received) {
+    BOOST_REQUIRE_EQUAL(key_pair.second.size(), messages_per_key);
+    for (uint64_t idx = 0; idx < messages_per_key; ++idx) {
+      BOOST_REQUIRE_EQUAL(key_pair.second[idx], idx);
+    }
+  }
+  BOOST_REQUIRE(threads.size() > 1);
+}
+
+BOOST_AUTO_TEST_CASE(Overruns)
+{
+  ConnectionStats stats;
+  stats.listener_activity().callback_budget = std::chrono::milliseconds(1);
+  {
+    KeyedDispatcher dispatcher(
+      [](ipm::Receiver::Response) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); },
+      [](ipm::Receiver::Response const&) { return 0; },
+      2,
+      "test",
+      &stats);
+    dispatcher.dispatch(make_response(0, 0), std::chrono::steady_clock::now());
+    dispatcher.dispatch(make_response(0, 1), std::chrono::steady_clock::now());
+  }
+  BOOST_REQUIRE_EQUAL(stats.listener_activity().callback_overruns.load(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(CallbackStart)
+{
+  ConnectionStats stats;
+  std::atomic<size_t> running{ 0 };
+  std::atomic<bool> release_first{ false };
+  std::atomic<bool> release_second{ false };
+  {
+    KeyedDispatcher dispatcher(
+      [&](ipm::Receiver::Response response) {
+        ++running;
+        auto& release = read_word(response, 1) == 0 ? release_first : release_second;
+        while (!release.load()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        --running;
+      },
+      [](ipm::Receiver::Response const& response) { return read_word(response, 0); },
+      2,
+      "test",
+      &stats);
+    uint64_t second_key = 1;
+    while (dispatcher.worker_for(second_key) == dispatcher.worker_for(0)) {
+      ++second_key;
+    }
+
+    dispatcher.dispatch(make_response(0, 0), std::chrono::steady_clock::now());
+    while (running.load() < 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto first_start_ns = stats.listener_activity().callback_start_ns.load();
+    BOOST_REQUIRE(first_start_ns != 0);
+
+    // The oldest running callback is the one reported
+    dispatcher.dispatch(make_response(second_key, 1), std::chrono::steady_clock::now());
+    while (running.load() < 2) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_REQUIRE_EQUAL(stats.listener_activity().callback_start_ns.load(), first_start_ns);
+
+    release_first = true;
+    while (running.load() > 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto second_start_ns = stats.listener_activity().callback_start_ns.load();
+    BOOST_REQUIRE(second_start_ns > first_start_ns);
+
+    release_second = true;
+  }
+  BOOST_REQUIRE_EQUAL(stats.listener_activity().callback_start_ns.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ThrowingCallback)
+{
+  ConnectionStats stats;
+  std::atomic<size_t> processed{ 0 };
+  {
+    KeyedDispatcher dispatcher(
+      [&](ipm::Receiver::Response response) {
+        ++processed;
+        if (read_word(response, 1) == 0) {
+          throw std::runtime_error("callback failure");
+        }
+      },
+      [](ipm::Receiver::Response const&) { return 0; },
+      2,
+      "test",
+      &stats);
+    dispatcher.dispatch(make_response(0, 0), std::chrono::steady_clock::now());
+    dispatcher.dispatch(make_response(0, 1), std::chrono::steady_clock::now());
+  }
+  // The worker survives the exception and goes on with the next message
+  BOOST_REQUIRE_EQUAL(processed.load(), 2);
+  BOOST_REQUIRE_EQUAL(stats.listener_activity().callback_start_ns.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ThrowingKeyExtractor)
+{
+  std::atomic<size_t> processed{ 0 };
+  {
+    KeyedDispatcher dispatcher(
+      [&](ipm::Receiver::Response) { ++processed; },
+      [](ipm::Receiver::Response const& response) {
+        if (read_word(response, 1) == 0) {
+          throw std::runtime_error("key extractor failure");
+        }
+        return read_word(response, 0);
+      },
+      2,
+      "test",
+      nullptr);
+    // The message without a key is dropped, on the calling thread, and the next one is dispatched
+    dispatcher.dispatch(make_response(0, 0), std::chrono::steady_clock::now());
+    dispatcher.dispatch(make_response(0, 1), std::chrono::steady_clock::now());
+  }
+  BOOST_REQUIRE_EQUAL(processed.load(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+/**
+ * @file LatencyHistogram_test.cxx LatencyHistogram class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/LatencyHistogram.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE LatencyHistogram_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogram_test)
+
+BOOST_AUTO_TEST_CASE(BucketIndex)
+{
+  // Small values have their own bucket
+  for (uint64_t value = 0; value < LatencyHistogram::s_sub_bucket_count * 2; ++value) {
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket_index(value), value);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket_upper_edge(value), value);
+  }
+
+  // Every value is at most its bucket's upper edge, and within the relative precision of it
+  size_t last_index = 0;
+  for (uint64_t value = 1; value < (1ULL << 30); value = value * 3 / 2 + 1) {
+    auto index = LatencyHistogram::bucket_index(value);
+    BOOST_REQUIRE(index >= last_index);
+    BOOST_REQUIRE(index < LatencyHistogram::s_bucket_count);
+    auto edge = LatencyHistogram::bucket_upper_edge(index);
+    BOOST_REQUIRE(value <= edge);
+    BOOST_REQUIRE(edge - value <= value / LatencyHistogram::s_sub_bucket_count);
+    last_index = index;
+  }
+
+  BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::s_bucket_count - 1);
+}
+
+BOOST_AUTO_TEST_CASE(Percentiles)
+{
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value * 1000);
+  }
+
+  auto summary = histogram.collect_and_reset();
+  BOOST_REQUIRE_EQUAL(summary.count, 1000);
+  BOOST_REQUIRE_CLOSE(summary.mean, 500500., 0.01);
+  BOOST_REQUIRE_CLOSE(summary.p50, 500000., 100. / LatencyHistogram::s_sub_bucket_count);
+  BOOST_REQUIRE_CLOSE(summary.p90, 900000., 100. / LatencyHistogram::s_sub_bucket_count);
+  BOOST_REQUIRE_CLOSE(summary.p99, 990000., 100. / LatencyHistogram::s_sub_bucket_count);
+  BOOST_REQUIRE_CLOSE(summary.max, 1000000., 100. / LatencyHistogram::s_sub_bucket_count);
+  BOOST_REQUIRE(summary.p50 <= summary.p90);
+  BOOST_REQUIRE(summary.p90 <= summary.p99);
+  BOOST_REQUIRE(summary.p99 <= summary.p999);
+  BOOST_REQUIRE(summary.p999 <= summary.max);
+
+  // The next interval starts empty
+  summary = histogram.collect_and_reset();
+  BOOST_REQUIRE_EQUAL(summary.count, 0);
+  BOOST_REQUIRE_EQUAL(summary.max, 0.);
+}
+
+BOOST_AUTO_TEST_CASE(FillInfo)
+{
+  LatencyHistogram histogram;
+  histogram.record(std::chrono::microseconds(10));
+  histogram.record(std::chrono::microseconds(-1));
+
+  dunedaq::networkmanager::connectioninfo::LatencyInfo info;
+  histogram.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.samples, 2);
+  BOOST_REQUIRE_CLOSE(info.max_us, 10., 100. / LatencyHistogram::s_sub_bucket_count);
+  BOOST_REQUIRE_EQUAL(info.p50_us, 0.);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,7 +16,10 @@
 
 #include "boost/test/unit_test.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -107,6 +110,21 @@ BOOST_FIXTURE_TEST_CASE(StartStop, NetworkManagerTestFixture)
   TLOG() << "StartStop test case END";
 }
 
+BOOST_FIXTURE_TEST_CASE(DrainingStop, NetworkManagerTestFixture)
+{
+  Listener l;
+  auto result = l.stop_listening(std::chrono::milliseconds(10)); // Should print ERS warning
+  BOOST_REQUIRE_EQUAL(result.drained, 0);
+  BOOST_REQUIRE(!result.timed_out);
+
+  l.start_listening("foo");
+  BOOST_REQUIRE(l.is_listening());
+  result = l.stop_listening(std::chrono::milliseconds(10));
+  BOOST_REQUIRE(!l.is_listening());
+  BOOST_REQUIRE_EQUAL(result.drained, 0);
+  BOOST_REQUIRE(!result.timed_out);
+}
+
 BOOST_FIXTURE_TEST_CASE(Shutdown, NetworkManagerTestFixture)
 {
   TLOG() << "Shutdown test case BEGIN";
@@ -125,6 +143,30 @@ BOOST_FIXTURE_TEST_CASE(Shutdown, NetworkManagerTestFixture)
   TLOG() << "Shutdown test case END";
 }
 
+BOOST_FIXTURE_TEST_CASE(RequestStop, NetworkManagerTestFixture)
+{
+  // The Listener is woken from its idle wait, rather than finishing it, once it is told to stop. A Listener
+  // which finished its wait would take s_idle_wait / 2 to stop on average.
+  Listener l;
+  std::vector<std::chrono::steady_clock::duration> stop_times;
+  for (int i = 0; i < 50; ++i) {
+    l.start_listening("foo");
+    BOOST_REQUIRE(l.is_listening());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto start = std::chrono::steady_clock::now();
+    l.request_stop();
+    BOOST_REQUIRE(!l.is_listening());
+    BOOST_REQUIRE(l.wait_stopped(start + std::chrono::milliseconds(1000)));
+    stop_times.push_back(std::chrono::steady_clock::now() - start);
+    l.join();
+    BOOST_REQUIRE(l.wait_stopped(std::chrono::steady_clock::now()));
+  }
+  std::sort(stop_times.begin(), stop_times.end());
+  BOOST_REQUIRE(stop_times[stop_times.size() / 2] < Listener::s_idle_wait / 10);
+  BOOST_REQUIRE(stop_times[stop_times.size() * 9 / 10] < Listener::s_idle_wait / 2);
+}
+
 BOOST_FIXTURE_TEST_CASE(Callback, NetworkManagerTestFixture)
 {
   TLOG() << "Callback test case BEGIN";
@@ -0,0 +1,152 @@
+/**
+ * @file MemoryTransport_test.cxx mem:// loopback transport Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Issues.hpp"
+#include "networkmanager/MemoryTransport.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE MemoryTransport_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(MemoryTransport_test)
+
+BOOST_AUTO_TEST_CASE(ParseAddress)
+{
+  std::string name;
+  auto parameters =
+    MemoryLinkParameters::parse("mem://link?latency_us=50&bandwidth_mbps=1000&drop_rate=0.25&seed=7&capacity=3", name);
+  BOOST_REQUIRE_EQUAL(name, "link");
+  BOOST_REQUIRE_EQUAL(parameters.latency.count(), 50);
+  BOOST_REQUIRE_EQUAL(parameters.bandwidth_mbps, 1000.);
+  BOOST_REQUIRE_EQUAL(parameters.drop_rate, 0.25);
+  BOOST_REQUIRE_EQUAL(parameters.seed, 7);
+  BOOST_REQUIRE_EQUAL(parameters.capacity, 3);
+
+  parameters = MemoryLinkParameters::parse("mem://plain", name);
+  BOOST_REQUIRE_EQUAL(name, "plain");
+  BOOST_REQUIRE_EQUAL(parameters.latency.count(), 0);
+
+  BOOST_REQUIRE(is_memory_address("mem://plain"));
+  BOOST_REQUIRE(!is_memory_address("inproc://plain"));
+  BOOST_REQUIRE_THROW(MemoryLinkParameters::parse("inproc://plain", name), InvalidAddress);
+  BOOST_REQUIRE_THROW(MemoryLinkParameters::parse("mem://", name), InvalidAddress);
+  BOOST_REQUIRE_THROW(MemoryLinkParameters::parse("mem://link?colour=blue", name), InvalidAddress);
+  BOOST_REQUIRE_THROW(MemoryLinkParameters::parse("mem://link?latency_us=soon", name), InvalidAddress);
+}
+
+BOOST_AUTO_TEST_CASE(SendReceive)
+{
+  MemorySender sender(false);
+  MemoryReceiver receiver;
+  BOOST_REQUIRE(!sender.can_send());
+  sender.connect_for_sends({ { "connection_string", "mem://send_receive" } });
+  receiver.connect_for_receives({ { "connection_string", "mem://send_receive" } });
+  BOOST_REQUIRE(sender.can_send());
+  BOOST_REQUIRE(receiver.can_receive());
+
+  std::string message = "hello";
+  sender.send(message.c_str(), message.size(), ipm::Sender::s_no_block, "meta");
+  auto response = receiver.receive(ipm::Receiver::s_no_block);
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), message);
+  BOOST_REQUIRE_EQUAL(response.metadata, "meta");
+
+  BOOST_REQUIRE_THROW(receiver.receive(std::chrono::milliseconds(10)), ipm::ReceiveTimeoutExpired);
+}
+
+BOOST_AUTO_TEST_CASE(Latency)
+{
+  MemorySender sender(false);
+  MemoryReceiver receiver;
+  sender.connect_for_sends({ { "connection_string", "mem://latency?latency_us=50000" } });
+  receiver.connect_for_receives({ { "connection_string", "mem://latency" } });
+
+  auto start = std::chrono::steady_clock::now();
+  std::string message = "delayed";
+  sender.send(message.c_str(), message.size(), ipm::Sender::s_no_block);
+  BOOST_REQUIRE_THROW(receiver.receive(ipm::Receiver::s_no_block), ipm::ReceiveTimeoutExpired);
+  receiver.receive(std::chrono::milliseconds(1000));
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+}
+
+BOOST_AUTO_TEST_CASE(Capacity)
+{
+  MemorySender sender(false);
+  MemoryReceiver receiver;
+  sender.connect_for_sends({ { "connection_string", "mem://capacity?capacity=2" } });
+  receiver.connect_for_receives({ { "connection_string", "mem://capacity" } });
+
+  std::string message = "fill";
+  sender.send(message.c_str(), message.size(), ipm::Sender::s_no_block);
+  sender.send(message.c_str(), message.size(), ipm::Sender::s_no_block);
+  BOOST_REQUIRE_THROW(sender.send(message.c_str(), message.size(), std::chrono::milliseconds(10)),
+                      ipm::SendTimeoutExpired);
+  receiver.receive(ipm::Receiver::s_no_block);
+  sender.send(message.c_str(), message.size(), ipm::Sender::s_no_block);
+}
+
+BOOST_AUTO_TEST_CASE(DeterministicDrops)
+{
+  auto count_received = [](std::string const& address) {
+    MemorySender sender(false);
+    MemoryReceiver receiver;
+    sender.connect_for_sends({ { "connection_string", address } });
+    receiver.connect_for_receives({ { "connection_string", address } });
+
+    std::string message = "maybe";
+    for (int idx = 0; idx < 1000; ++idx) {
+      sender.send(message.c_str(), message.size(), ipm::Sender::s_no_block);
+    }
+    size_t received = 0;
+    try {
+      while (true) {
+        receiver.receive(ipm::Receiver::s_no_block);
+        ++received;
+      }
+    } catch (ipm::ReceiveTimeoutExpired const&) {
+    }
+    return received;
+  };
+
+  // The channel is closed between runs, so the second run starts from the same seed
+  auto first = count_received("mem://drops?drop_rate=0.5&seed=42");
+  auto second = count_received("mem://drops?drop_rate=0.5&seed=42");
+  BOOST_REQUIRE_EQUAL(first, second);
+  BOOST_REQUIRE_GT(first, 400);
+  BOOST_REQUIRE_LT(first, 600);
+}
+
+BOOST_AUTO_TEST_CASE(PublishSubscribe)
+{
+  MemorySender publisher(true);
+  MemorySubscriber subscriber;
+  publisher.connect_for_sends({ { "connection_string", "mem://pubsub" } });
+  subscriber.connect_for_receives({ { "connection_strings", std::vector<std::string>{ "mem://pubsub" } } });
+  subscriber.subscribe("foo");
+
+  std::string message = "news";
+  publisher.send(message.c_str(), message.size(), ipm::Sender::s_no_block, "bar");
+  publisher.send(message.c_str(), message.size(), ipm::Sender::s_no_block, "foobar");
+  auto response = subscriber.receive(ipm::Receiver::s_no_block);
+  BOOST_REQUIRE_EQUAL(response.metadata, "foobar");
+  BOOST_REQUIRE_THROW(subscriber.receive(ipm::Receiver::s_no_block), ipm::ReceiveTimeoutExpired);
+
+  subscriber.unsubscribe("foo");
+  publisher.send(message.c_str(), message.size(), ipm::Sender::s_no_block, "foo");
+  BOOST_REQUIRE_THROW(subscriber.receive(ipm::Receiver::s_no_block), ipm::ReceiveTimeoutExpired);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
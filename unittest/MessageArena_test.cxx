@@ -0,0 +1,125 @@
+/**
+ * @file MessageArena_test.cxx MessageArena and ArenaBuffer Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/MessageArena.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE MessageArena_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(MessageArena_test)
+
+BOOST_AUTO_TEST_CASE(SizeClasses)
+{
+  BOOST_REQUIRE_EQUAL(MessageArena::size_class(0), 0);
+  BOOST_REQUIRE_EQUAL(MessageArena::size_class(MessageArena::s_min_block_size), 0);
+  BOOST_REQUIRE_EQUAL(MessageArena::size_class(MessageArena::s_min_block_size + 1), 1);
+  BOOST_REQUIRE_EQUAL(MessageArena::size_class(1024 * 1024), 8);
+}
+
+BOOST_AUTO_TEST_CASE(AllocateAndRelease)
+{
+  auto arena = MessageArena::create(1, false, true);
+  BOOST_REQUIRE_EQUAL(arena->capacity(), MessageArena::s_huge_page_size);
+
+  connectioninfo::ArenaInfo info;
+  {
+    auto buffer = arena->allocate(100000);
+    BOOST_REQUIRE(buffer.from_arena());
+    BOOST_REQUIRE_EQUAL(buffer.size(), 100000);
+    memset(buffer.data(), 'x', buffer.size());
+
+    arena->fill_info(info);
+    BOOST_REQUIRE_EQUAL(info.used_bytes, 128 * 1024);
+    BOOST_REQUIRE_EQUAL(info.allocations, 1);
+
+    // Ownership moves with the buffer
+    auto moved = std::move(buffer);
+    BOOST_REQUIRE(moved.from_arena());
+    BOOST_REQUIRE(buffer.data() == nullptr);
+  }
+  arena->fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.used_bytes, 0);
+  BOOST_REQUIRE_EQUAL(info.peak_used_bytes, 128 * 1024);
+
+  // A released block is reused for the next buffer of the same size class
+  auto first = arena->allocate(100000);
+  auto first_data = first.data();
+  first = ArenaBuffer();
+  auto second = arena->allocate(70000);
+  BOOST_REQUIRE_EQUAL(second.data(), first_data);
+}
+
+BOOST_AUTO_TEST_CASE(SplitAndMerge)
+{
+  // Three hugepages: a block of two and a block of one
+  auto arena = MessageArena::create(3 * MessageArena::s_huge_page_size, false, false);
+
+  // Small buffers fill the whole arena
+  std::vector<ArenaBuffer> buffers;
+  while (true) {
+    buffers.push_back(arena->allocate(MessageArena::s_min_block_size));
+    if (!buffers.back().from_arena()) {
+      buffers.pop_back();
+      break;
+    }
+  }
+  BOOST_REQUIRE_EQUAL(buffers.size(), arena->capacity() / MessageArena::s_min_block_size);
+
+  // Once they are freed, they merge back into blocks large enough for buffers of any size class
+  buffers.clear();
+  auto large = arena->allocate(2 * MessageArena::s_huge_page_size);
+  BOOST_REQUIRE(large.from_arena());
+  auto medium = arena->allocate(MessageArena::s_huge_page_size);
+  BOOST_REQUIRE(medium.from_arena());
+  BOOST_REQUIRE(!arena->allocate(1).from_arena());
+
+  // A hugepage split in halves is only available again once both halves are free
+  medium = ArenaBuffer();
+  auto first_half = arena->allocate(MessageArena::s_huge_page_size / 2);
+  auto second_half = arena->allocate(MessageArena::s_huge_page_size / 2);
+  BOOST_REQUIRE(first_half.from_arena());
+  BOOST_REQUIRE(second_half.from_arena());
+  first_half = ArenaBuffer();
+  BOOST_REQUIRE(!arena->allocate(MessageArena::s_huge_page_size).from_arena());
+  second_half = ArenaBuffer();
+  BOOST_REQUIRE(arena->allocate(MessageArena::s_huge_page_size).from_arena());
+}
+
+BOOST_AUTO_TEST_CASE(HeapFallback)
+{
+  auto arena = MessageArena::create(MessageArena::s_huge_page_size, true, false);
+
+  std::vector<ArenaBuffer> buffers;
+  buffers.push_back(arena->allocate(MessageArena::s_huge_page_size));
+  BOOST_REQUIRE(buffers.back().from_arena());
+  buffers.push_back(arena->allocate(1));
+  BOOST_REQUIRE(!buffers.back().from_arena());
+  buffers.push_back(arena->allocate(2 * MessageArena::s_huge_page_size));
+  BOOST_REQUIRE(!buffers.back().from_arena());
+  BOOST_REQUIRE_EQUAL(buffers.back().size(), 2 * MessageArena::s_huge_page_size);
+
+  connectioninfo::ArenaInfo info;
+  arena->fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.allocations, 1);
+  BOOST_REQUIRE_EQUAL(info.fallback_allocations, 2);
+
+  // Buffers keep the arena alive
+  arena.reset();
+  memset(buffers.front().data(), 'x', buffers.front().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
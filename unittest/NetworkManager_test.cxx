@@ -10,12 +10,21 @@
 #include "networkmanager/nwmgr/Structs.hpp"
 
 #include "logging/Logging.hpp"
+#include "opmonlib/JSONTags.hpp"
 
 #define BOOST_TEST_MODULE NetworkManager_test // NOLINT
 
 #include "boost/test/unit_test.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #pragma GCC diagnostic push
@@ -23,6 +32,52 @@
 
 using namespace dunedaq::networkmanager;
 
+namespace {
+// A field of the Infos in node's properties, wherever below them the InfoCollector puts it; null if there is none
+nlohmann::json
+find_field(nlohmann::json const& node, std::string const& field)
+{
+  if (!node.is_object()) {
+    return nullptr;
+  }
+  if (node.contains(field)) {
+    return node[field];
+  }
+  for (auto& child : node) {
+    auto value = find_field(child, field);
+    if (!value.is_null()) {
+      return value;
+    }
+  }
+  return nullptr;
+}
+
+// A field reported by gather_stats for a connection or topic, or under one of its entries, such as "requests"
+nlohmann::json
+reported_value(dunedaq::opmonlib::InfoCollector& ci,
+               std::string const& name,
+               std::string const& field,
+               std::string const& entry = "")
+{
+  auto infos = ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children][name];
+  if (!entry.empty()) {
+    infos = infos[dunedaq::opmonlib::JSONTags::children][entry];
+  }
+  auto value = find_field(infos[dunedaq::opmonlib::JSONTags::properties], field);
+  BOOST_REQUIRE_MESSAGE(!value.is_null(), name + " reports no " + field);
+  return value;
+}
+
+uint64_t
+reported_counter(dunedaq::opmonlib::InfoCollector& ci,
+                 std::string const& name,
+                 std::string const& field,
+                 std::string const& entry = "")
+{
+  return reported_value(ci, name, field, entry).get<uint64_t>();
+}
+} // namespace
+
 BOOST_AUTO_TEST_SUITE(NetworkManager_test)
 
 struct NetworkManagerTestFixture
@@ -76,6 +131,65 @@ BOOST_AUTO_TEST_CASE(Singleton)
   BOOST_REQUIRE_EQUAL(&nm, &another_nm);
 }
 
+BOOST_FIXTURE_TEST_CASE(IndependentInstances, NetworkManagerTestFixture)
+{
+  NetworkManager first;
+  NetworkManager second;
+  first.configure({ { "foo", "inproc://first_foo", {} } });
+  second.configure({ { "foo", "inproc://second_foo", {} } });
+  BOOST_REQUIRE_EQUAL(first.get_connection_string("foo"), "inproc://first_foo");
+  BOOST_REQUIRE_EQUAL(second.get_connection_string("foo"), "inproc://second_foo");
+  BOOST_REQUIRE_EQUAL(NetworkManager::get().get_connection_string("foo"), "inproc://foo");
+
+  std::atomic<size_t> received_on_second{ 0 };
+  second.start_listening("foo");
+  second.register_callback("foo", [&](dunedaq::ipm::Receiver::Response) { ++received_on_second; });
+  BOOST_REQUIRE(second.is_listening("foo"));
+  BOOST_REQUIRE(!first.is_listening("foo"));
+  BOOST_REQUIRE(!NetworkManager::get().is_listening("foo"));
+
+  std::string sent_string = "this is a test string";
+  first.send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  auto response = first.receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+
+  second.send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  for (int i = 0; i < 100 && received_on_second == 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  BOOST_REQUIRE_EQUAL(received_on_second, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(SenderIdPerConfiguration, NetworkManagerTestFixture)
+{
+  NetworkManager sender;
+  NetworkManager receiver;
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "enveloped";
+  testConn.address = "mem://sender_id";
+  testConn.envelope = true;
+  testConfig.push_back(testConn);
+  receiver.configure(testConfig);
+  receiver.get_receiver("enveloped");
+
+  // The receiver keeps its sequence tracking while the sender is reconfigured and numbers from 0 again
+  std::string sent_string = "this is a test string";
+  for (int configuration = 0; configuration < 2; ++configuration) {
+    sender.configure(testConfig);
+    for (int i = 0; i < 3; ++i) {
+      sender.send_to("enveloped", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+      receiver.receive_from("enveloped", std::chrono::milliseconds(1000));
+    }
+    sender.reset();
+  }
+
+  dunedaq::opmonlib::InfoCollector ci;
+  receiver.gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "enveloped", "out_of_order_messages"), 0);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "enveloped", "missing_messages"), 0);
+}
+
 BOOST_FIXTURE_TEST_CASE(FakeConfigure, NetworkManagerTestFixture)
 {
   BOOST_REQUIRE_EQUAL(NetworkManager::get().get_connection_string("foo"), "inproc://foo");
@@ -85,6 +199,12 @@ BOOST_FIXTURE_TEST_CASE(FakeConfigure, NetworkManagerTestFixture)
   BOOST_REQUIRE(strings[0] == "inproc://bar" || strings[1] == "inproc://bar");
   BOOST_REQUIRE(strings[0] == "inproc://rab" || strings[1] == "inproc://rab");
 
+  // Lookups return views of the resolution made by configure, rather than copies
+  BOOST_REQUIRE_EQUAL(&NetworkManager::get().get_connection_strings("baz"),
+                      &NetworkManager::get().get_connection_strings("baz"));
+  BOOST_REQUIRE_EQUAL(&NetworkManager::get().get_connection_string("foo"),
+                      &NetworkManager::get().get_connection_string("foo"));
+
   BOOST_REQUIRE_EXCEPTION(NetworkManager::get().get_connection_string("blahblah"),
                           ConnectionNotFound,
                           [&](ConnectionNotFound const&) { return true; });
@@ -318,6 +438,777 @@ BOOST_FIXTURE_TEST_CASE(SendTo, NetworkManagerTestFixture)
   BOOST_REQUIRE_EQUAL(received_string, sent_string);
 }
 
+BOOST_FIXTURE_TEST_CASE(ReconfigureAfterUse, NetworkManagerTestFixture)
+{
+  std::string sent_string = "this is a test string";
+  auto sender = NetworkManager::get().get_sender("foo");
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+
+  // Plugins cached by this thread must not be reused once the connection has been reconfigured
+  NetworkManager::get().reset();
+  NetworkManager::get().configure({ { "foo", "inproc://oof", {} } });
+  BOOST_REQUIRE(NetworkManager::get().get_sender("foo") != sender);
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  auto response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+}
+
+BOOST_FIXTURE_TEST_CASE(GatherStats, NetworkManagerTestFixture)
+{
+  dunedaq::opmonlib::InfoCollector empty_ci;
+  NetworkManager::get().reset();
+  NetworkManager::get().gather_stats(empty_ci, 0);
+  BOOST_REQUIRE(empty_ci.is_empty());
+
+  nwmgr::Connections testConfig;
+  testConfig.push_back({ "foo", "inproc://foo", {} });
+  NetworkManager::get().configure(testConfig);
+
+  std::string sent_string = "this is a test string";
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  auto response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  BOOST_REQUIRE_EQUAL(response.data.size(), sent_string.size());
+
+  // Level 0 only reports the totals
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, 0);
+  auto children = ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children];
+  BOOST_REQUIRE_EQUAL(children.size(), 1);
+  BOOST_REQUIRE(children.contains(NetworkManager::s_totals_stats_name));
+
+  // Connections are reported from s_connection_stats_level on, as long as they have news
+  dunedaq::opmonlib::InfoCollector connection_ci;
+  NetworkManager::get().gather_stats(connection_ci, NetworkManager::s_connection_stats_level);
+  children = connection_ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children];
+  BOOST_REQUIRE(children.contains("foo"));
+  // The next report brings the rates back to zero, and the one after has nothing new
+  dunedaq::opmonlib::InfoCollector zero_rates_ci;
+  NetworkManager::get().gather_stats(zero_rates_ci, NetworkManager::s_connection_stats_level);
+  dunedaq::opmonlib::InfoCollector unchanged_ci;
+  NetworkManager::get().gather_stats(unchanged_ci, NetworkManager::s_connection_stats_level);
+  children = unchanged_ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children];
+  BOOST_REQUIRE(!children.contains("foo"));
+
+  // Detailed statistics turn on the latency histograms for subsequent traffic
+  dunedaq::opmonlib::InfoCollector detailed_ci;
+  NetworkManager::get().gather_stats(detailed_ci, NetworkManager::s_latency_stats_level);
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  NetworkManager::get().gather_stats(detailed_ci, NetworkManager::s_latency_stats_level);
+  BOOST_REQUIRE(reported_counter(detailed_ci, "foo", "samples", "send_time") > 0);
+
+  // A lower level turns them off again, so that traffic until the next detailed report is not recorded
+  dunedaq::opmonlib::InfoCollector undetailed_ci;
+  NetworkManager::get().gather_stats(undetailed_ci, NetworkManager::s_connection_stats_level);
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  dunedaq::opmonlib::InfoCollector redetailed_ci;
+  NetworkManager::get().gather_stats(redetailed_ci, NetworkManager::s_latency_stats_level);
+  children = redetailed_ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children];
+  BOOST_REQUIRE(children.contains("foo"));
+  BOOST_REQUIRE(!children["foo"][dunedaq::opmonlib::JSONTags::children].contains("send_time"));
+
+  // Lock statistics are recorded once requested, and then reported for the global and per-connection locks
+  dunedaq::opmonlib::InfoCollector lock_ci;
+  NetworkManager::get().gather_stats(lock_ci, NetworkManager::s_lock_stats_level);
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  NetworkManager::get().gather_stats(lock_ci, NetworkManager::s_lock_stats_level);
+  BOOST_REQUIRE(InstrumentedMutex::is_enabled());
+  BOOST_REQUIRE(reported_counter(lock_ci, "foo", "acquisitions", "connection_lock") > 0);
+
+  // A lower level switches recording off again
+  dunedaq::opmonlib::InfoCollector lower_ci;
+  NetworkManager::get().gather_stats(lower_ci, NetworkManager::s_latency_stats_level);
+  BOOST_REQUIRE(!InstrumentedMutex::is_enabled());
+}
+
+BOOST_FIXTURE_TEST_CASE(KeyedCallback, NetworkManagerTestFixture)
+{
+  const size_t message_count = 100;
+  std::mutex received_mutex;
+  std::vector<std::string> received;
+
+  NetworkManager::get().start_listening("foo");
+  NetworkManager::get().register_callback(
+    "foo",
+    [&](dunedaq::ipm::Receiver::Response response) {
+      std::lock_guard<std::mutex> lk(received_mutex);
+      received.emplace_back(response.data.begin(), response.data.end());
+    },
+    [](dunedaq::ipm::Receiver::Response const& response) { return response.data.empty() ? 0 : response.data[0]; },
+    4);
+
+  for (size_t idx = 0; idx < message_count; ++idx) {
+    auto message = std::string(1, static_cast<char>('a' + idx % 4)) + std::to_string(idx);
+    NetworkManager::get().send_to("foo", message.c_str(), message.size(), dunedaq::ipm::Sender::s_block);
+  }
+  for (int i = 0; i < 500; ++i) {
+    {
+      std::lock_guard<std::mutex> lk(received_mutex);
+      if (received.size() == message_count) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  NetworkManager::get().stop_listening("foo");
+
+  // Messages with the same first character (the key) arrive in the order they were sent
+  BOOST_REQUIRE_EQUAL(received.size(), message_count);
+  std::map<char, int> last_index;
+  for (auto& message : received) {
+    auto index = std::stoi(message.substr(1));
+    if (last_index.count(message[0])) {
+      BOOST_REQUIRE(index > last_index[message[0]]);
+    }
+    last_index[message[0]] = index;
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(CallbackBudget, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "foo";
+  testConn.address = "inproc://foo";
+  testConn.callback_budget_ms = 10;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  std::atomic<bool> in_callback{ false };
+  std::atomic<bool> release_callback{ false };
+  NetworkManager::get().start_listening("foo");
+  NetworkManager::get().register_callback("foo", [&](dunedaq::ipm::Receiver::Response) {
+    in_callback = true;
+    while (!release_callback) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  std::string sent_string = "this is a test string";
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  while (!in_callback) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // The callback is stalled past its budget, which gather_stats reports while it is still running
+  dunedaq::opmonlib::InfoCollector stalled_ci;
+  NetworkManager::get().gather_stats(stalled_ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE(reported_value(stalled_ci, "foo", "seconds_in_callback").get<double>() >= 0.02);
+  BOOST_REQUIRE_EQUAL(reported_counter(stalled_ci, "foo", "callback_overruns"), 0);
+
+  // Once it returns, it counts as an overrun
+  release_callback = true;
+  NetworkManager::get().stop_listening("foo");
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "foo", "callback_overruns"), 1);
+  BOOST_REQUIRE_EQUAL(reported_value(ci, "foo", "seconds_in_callback").get<double>(), 0.);
+}
+
+BOOST_FIXTURE_TEST_CASE(Envelope, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "foo";
+  testConn.address = "inproc://foo";
+  testConn.envelope = true;
+  testConfig.push_back(testConn);
+  testConn.name = "bar";
+  testConn.address = "inproc://bar";
+  testConn.topics = { "bax" };
+  testConfig.push_back(testConn);
+  testConn.name = "rab";
+  testConn.address = "inproc://rab";
+  testConn.envelope = false;
+  testConfig.push_back(testConn);
+  BOOST_REQUIRE_EXCEPTION(
+    NetworkManager::get().configure(testConfig), EnvelopeMismatch, [&](EnvelopeMismatch const&) { return true; });
+
+  testConfig.pop_back();
+  NetworkManager::get().configure(testConfig);
+
+  std::string sent_string = "this is an enveloped test string";
+  for (int i = 0; i < 3; ++i) {
+    NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+    auto response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+    BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+  }
+
+  // Another sender skips sequence numbers 1 and 2, and then sends 2 late
+  for (uint64_t sequence_number : { 0, 3, 2 }) {
+    EnvelopeHeader header;
+    header.sequence_number = sequence_number;
+    header.sender_id = 42;
+    std::vector<char> message(EnvelopeHeader::s_size + sent_string.size());
+    header.write(message.data());
+    memcpy(message.data() + EnvelopeHeader::s_size, sent_string.c_str(), sent_string.size());
+    NetworkManager::get().get_sender("foo")->send(message.data(), message.size(), dunedaq::ipm::Sender::s_block);
+    auto response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+    BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+  }
+
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "foo", "missing_messages"), 1);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "foo", "out_of_order_messages"), 1);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "foo", "invalid_envelopes"), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(Arena, NetworkManagerTestFixture)
+{
+  auto heap_buffer = NetworkManager::get().allocate_buffer(1024);
+  BOOST_REQUIRE(!heap_buffer.from_arena());
+
+  NetworkManager::get().reset();
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "foo";
+  testConn.address = "inproc://foo";
+  testConn.envelope = true;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  nwmgr::Arena arena_conf;
+  arena_conf.size = 4 * 1024 * 1024;
+  NetworkManager::get().configure_arena(arena_conf);
+
+  auto buffer = NetworkManager::get().allocate_buffer(1024 * 1024);
+  BOOST_REQUIRE(buffer.from_arena());
+  memset(buffer.data(), 'x', buffer.size());
+  NetworkManager::get().send_to("foo", buffer.data(), buffer.size(), dunedaq::ipm::Sender::s_block);
+  auto response = NetworkManager::get().receive_from("foo", dunedaq::ipm::Receiver::s_block);
+  BOOST_REQUIRE_EQUAL(response.data.size(), buffer.size());
+  BOOST_REQUIRE_EQUAL(response.data.back(), 'x');
+
+  // A buffer larger than the arena comes from the heap instead
+  auto oversized_buffer = NetworkManager::get().allocate_buffer(2 * arena_conf.size);
+  BOOST_REQUIRE(!oversized_buffer.from_arena());
+
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, 0);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, NetworkManager::s_arena_stats_name, "capacity_bytes"), arena_conf.size);
+  BOOST_REQUIRE(reported_counter(ci, NetworkManager::s_arena_stats_name, "used_bytes") >= buffer.size());
+  BOOST_REQUIRE(reported_counter(ci, NetworkManager::s_arena_stats_name, "allocations") >= 1);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, NetworkManager::s_arena_stats_name, "fallback_allocations"), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(MemoryTransport, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  testConfig.push_back({ "foo", "mem://foo?latency_us=10", {} });
+  testConfig.push_back({ "bar", "mem://bar", { "bax" } });
+  NetworkManager::get().configure(testConfig);
+
+  std::string sent_string = "this is a test string";
+  NetworkManager::get().send_to("foo", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  auto response = NetworkManager::get().receive_from("foo", std::chrono::milliseconds(1000));
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+
+  NetworkManager::get().start_publisher("bar");
+  NetworkManager::get().get_receiver("bax");
+  NetworkManager::get().send_to(
+    "bar", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block, "bax");
+  response = NetworkManager::get().receive_from("bax", std::chrono::milliseconds(1000));
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+  BOOST_REQUIRE_EQUAL(response.metadata, "bax");
+}
+
+BOOST_FIXTURE_TEST_CASE(Failover, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  // The primary address is invalid, so the sender connects to the alternate straight away
+  testConn.name = "invalid_primary";
+  testConn.address = "mem://invalid?unknown_parameter=1";
+  testConn.alternate_addresses = { "mem://invalid_primary_alternate" };
+  testConfig.push_back(testConn);
+  // Once the single slot of the primary is full, sends time out, and after s_failover_timeouts of them the sender
+  // fails over
+  testConn.name = "full_primary";
+  testConn.address = "mem://full_primary?capacity=1";
+  testConn.alternate_addresses = { "mem://full_primary_alternate" };
+  testConn.reconnect_backoff_ms = 10;
+  testConfig.push_back(testConn);
+  // No address works, so sends fail straight away while reconnects are retried
+  testConn.name = "unavailable";
+  testConn.address = "mem://unavailable?unknown_parameter=1";
+  testConn.alternate_addresses = {};
+  testConfig.push_back(testConn);
+  testConfig.push_back({ "invalid_primary_alternate", "mem://invalid_primary_alternate", {} });
+  testConfig.push_back({ "full_primary_alternate", "mem://full_primary_alternate", {} });
+  NetworkManager::get().configure(testConfig);
+
+  std::string sent_string = "this is a test string";
+  std::chrono::milliseconds timeout(10);
+  NetworkManager::get().send_to(
+    "invalid_primary", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  auto response = NetworkManager::get().receive_from("invalid_primary_alternate", std::chrono::milliseconds(1000));
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+
+  NetworkManager::get().get_receiver("full_primary_alternate");
+  NetworkManager::get().send_to(
+    "full_primary", sent_string.c_str(), sent_string.size(), std::chrono::milliseconds(10));
+  for (size_t idx = 0; idx < NetworkManager::s_failover_timeouts; ++idx) {
+    BOOST_REQUIRE_EXCEPTION(
+      NetworkManager::get().send_to("full_primary", sent_string.c_str(), sent_string.size(), timeout),
+      dunedaq::ipm::SendTimeoutExpired,
+      [&](dunedaq::ipm::SendTimeoutExpired const&) { return true; });
+  }
+  bool sent = false;
+  for (int i = 0; i < 1000 && !sent; ++i) {
+    try {
+      NetworkManager::get().send_to(
+        "full_primary", sent_string.c_str(), sent_string.size(), std::chrono::milliseconds(10));
+      sent = true;
+    } catch (ConnectionUnavailable const&) {
+      usleep(1000);
+    }
+  }
+  BOOST_REQUIRE(sent);
+  response = NetworkManager::get().receive_from("full_primary_alternate", std::chrono::milliseconds(1000));
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+
+  BOOST_REQUIRE_EXCEPTION(
+    NetworkManager::get().send_to("unavailable", sent_string.c_str(), sent_string.size(), timeout),
+    InvalidAddress,
+    [&](InvalidAddress const&) { return true; });
+  BOOST_REQUIRE_EXCEPTION(
+    NetworkManager::get().send_to("unavailable", sent_string.c_str(), sent_string.size(), timeout),
+    ConnectionUnavailable,
+    [&](ConnectionUnavailable const&) { return true; });
+
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "full_primary", "failovers"), 1);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "full_primary", "reconnects"), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(Tuning, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "tuned";
+  testConn.address = "mem://tuned";
+  testConn.tuning.hwm = 2;
+  testConn.tuning.linger_ms = 0;
+  testConn.tuning.poll_timeout_ms = 5;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  // The memory transport takes the high-water mark as the capacity of its queue
+  std::string sent_string = "this is a test string";
+  std::chrono::milliseconds timeout(10);
+  NetworkManager::get().send_to("tuned", sent_string.c_str(), sent_string.size(), timeout);
+  NetworkManager::get().send_to("tuned", sent_string.c_str(), sent_string.size(), timeout);
+  BOOST_REQUIRE_EXCEPTION(
+    NetworkManager::get().send_to("tuned", sent_string.c_str(), sent_string.size(), timeout),
+    dunedaq::ipm::SendTimeoutExpired,
+    [&](dunedaq::ipm::SendTimeoutExpired const&) { return true; });
+
+  // A Listener with a poll timeout receives as one that polls without waiting
+  std::atomic<bool> received{ false };
+  NetworkManager::get().start_listening("tuned");
+  NetworkManager::get().register_callback("tuned", [&](dunedaq::ipm::Receiver::Response) { received = true; });
+  NetworkManager::get().send_to("tuned", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  while (!received) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  NetworkManager::get().stop_listening("tuned");
+}
+
+BOOST_FIXTURE_TEST_CASE(BusyPoll, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "busy";
+  testConn.address = "mem://busy";
+  testConn.tuning.busy_poll_us = 100000;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  std::atomic<int> received{ 0 };
+  NetworkManager::get().start_listening("busy");
+  NetworkManager::get().register_callback("busy", [&](dunedaq::ipm::Receiver::Response) { ++received; });
+
+  // The second message arrives while the Listener is busy polling after the first
+  std::string sent_string = "this is a test string";
+  NetworkManager::get().send_to("busy", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  while (received < 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  NetworkManager::get().send_to("busy", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  while (received < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  NetworkManager::get().stop_listening("busy");
+
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE(ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children].contains("busy"));
+}
+
+BOOST_FIXTURE_TEST_CASE(Striping, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "striped";
+  testConn.address = "mem://striped_0";
+  testConn.stripe_addresses = { "mem://striped_1", "mem://striped_2" };
+  testConn.envelope = true;
+  testConn.stripe_ordered = true;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  // Messages spread over the stripes come out in the order they were sent
+  NetworkManager::get().get_receiver("striped");
+  for (int i = 0; i < 30; ++i) {
+    auto sent_string = std::to_string(i);
+    NetworkManager::get().send_to("striped", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  }
+  for (int i = 0; i < 30; ++i) {
+    auto response = NetworkManager::get().receive_from("striped", std::chrono::milliseconds(1000));
+    BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), std::to_string(i));
+  }
+
+  NetworkManager::get().reset();
+  testConfig[0].envelope = false;
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().configure(testConfig),
+                          InvalidStriping,
+                          [&](InvalidStriping const&) { return true; });
+  testConfig[0].stripe_ordered = false;
+  testConfig[0].alternate_addresses = { "mem://striped_alternate" };
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().configure(testConfig),
+                          InvalidStriping,
+                          [&](InvalidStriping const&) { return true; });
+}
+
+BOOST_FIXTURE_TEST_CASE(DrainOnStop, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "drain";
+  testConn.address = "mem://drain";
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  std::atomic<size_t> received{ 0 };
+  NetworkManager::get().start_listening("drain");
+  // Callbacks may use the registration API while the queued messages are delivered
+  NetworkManager::get().register_callback("drain", [&](dunedaq::ipm::Receiver::Response) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    NetworkManager::get().is_listening("drain");
+    ++received;
+  });
+
+  // Everything queued is delivered when there is time for it
+  std::string sent_string = "this is a test string";
+  for (int i = 0; i < 20; ++i) {
+    NetworkManager::get().send_to("drain", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  }
+  auto result = NetworkManager::get().stop_listening("drain", std::chrono::milliseconds(5000));
+  BOOST_REQUIRE(!NetworkManager::get().is_listening("drain"));
+  BOOST_REQUIRE_EQUAL(received, 20);
+  BOOST_REQUIRE(result.drained > 0);
+  BOOST_REQUIRE(!result.timed_out);
+
+  // What is left at the deadline stays queued
+  received = 0;
+  NetworkManager::get().start_listening("drain");
+  NetworkManager::get().register_callback("drain", [&](dunedaq::ipm::Receiver::Response) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ++received;
+  });
+  for (int i = 0; i < 50; ++i) {
+    NetworkManager::get().send_to("drain", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  }
+  auto stop_start = std::chrono::steady_clock::now();
+  result = NetworkManager::get().stop_listening("drain", std::chrono::milliseconds(50));
+  // Stopping takes at most the deadline and the last callback, not longer
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - stop_start < std::chrono::milliseconds(500));
+  BOOST_REQUIRE(result.timed_out);
+  BOOST_REQUIRE(result.drained <= received);
+  size_t left = 0;
+  try {
+    while (true) {
+      NetworkManager::get().receive_from("drain", dunedaq::ipm::Receiver::s_no_block);
+      ++left;
+    }
+  } catch (dunedaq::ipm::ReceiveTimeoutExpired const&) {
+  }
+  BOOST_REQUIRE(left > 0);
+  BOOST_REQUIRE_EQUAL(received + left, 50);
+
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().stop_listening("drain", std::chrono::milliseconds(50)),
+                          ListenerNotRegistered,
+                          [&](ListenerNotRegistered const&) { return true; });
+
+  // Restarting the Listener, or resetting, while it is being drained waits for the drain to finish
+  std::atomic<bool> draining{ false };
+  received = 0;
+  NetworkManager::get().start_listening("drain");
+  NetworkManager::get().register_callback("drain", [&](dunedaq::ipm::Receiver::Response) {
+    draining = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ++received;
+  });
+  for (int i = 0; i < 5; ++i) {
+    NetworkManager::get().send_to("drain", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  }
+  while (!draining) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto drain = std::async(std::launch::async, [&] {
+    return NetworkManager::get().stop_listening("drain", std::chrono::milliseconds(5000));
+  });
+  while (NetworkManager::get().is_listening("drain")) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  NetworkManager::get().start_listening("drain");
+  BOOST_REQUIRE(drain.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+  BOOST_REQUIRE(!drain.get().timed_out);
+  BOOST_REQUIRE_EQUAL(received, 5);
+
+  NetworkManager::get().register_callback("drain", [&](dunedaq::ipm::Receiver::Response) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ++received;
+  });
+  for (int i = 0; i < 5; ++i) {
+    NetworkManager::get().send_to("drain", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  }
+  drain = std::async(std::launch::async, [&] {
+    return NetworkManager::get().stop_listening("drain", std::chrono::milliseconds(5000));
+  });
+  while (NetworkManager::get().is_listening("drain")) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  NetworkManager::get().reset();
+  BOOST_REQUIRE(drain.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+  drain.get();
+  BOOST_REQUIRE_EQUAL(received, 10);
+}
+
+BOOST_FIXTURE_TEST_CASE(ParallelTeardown, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  for (int i = 0; i < 100; ++i) {
+    nwmgr::Connection testConn;
+    testConn.name = "teardown_" + std::to_string(i);
+    testConn.address = "mem://" + testConn.name;
+    testConfig.push_back(testConn);
+  }
+  NetworkManager::get().configure(testConfig);
+  for (auto& connection : testConfig) {
+    NetworkManager::get().start_listening(connection.name);
+    NetworkManager::get().get_sender(connection.name);
+  }
+
+  // Listeners stopped one after another would each finish their idle wait first
+  auto start = std::chrono::steady_clock::now();
+  NetworkManager::get().reset();
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < NetworkManager::s_teardown_timeout);
+  BOOST_REQUIRE(!NetworkManager::get().is_connection("teardown_0"));
+  BOOST_REQUIRE(!NetworkManager::get().is_listening("teardown_0"));
+}
+
+BOOST_FIXTURE_TEST_CASE(Chunking, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "chunked";
+  testConn.address = "mem://chunked";
+  testConn.envelope = true;
+  testConn.chunk_size = 1000;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  // A large message goes out in chunks, and a small one may go out between them
+  std::string large_string(10500, 'x');
+  for (size_t idx = 0; idx < large_string.size(); ++idx) {
+    large_string[idx] = static_cast<char>('a' + idx % 26);
+  }
+  std::string small_string = "small";
+  NetworkManager::get().get_receiver("chunked");
+  auto large_send = std::async(std::launch::async, [&] {
+    NetworkManager::get().send_to(
+      "chunked", large_string.c_str(), large_string.size(), dunedaq::ipm::Sender::s_block);
+  });
+  NetworkManager::get().send_to("chunked", small_string.c_str(), small_string.size(), dunedaq::ipm::Sender::s_block);
+  large_send.get();
+
+  std::vector<std::string> received;
+  for (int i = 0; i < 2; ++i) {
+    auto response = NetworkManager::get().receive_from("chunked", std::chrono::milliseconds(1000));
+    received.emplace_back(response.data.begin(), response.data.end());
+  }
+  std::sort(received.begin(), received.end(), [](auto& a, auto& b) { return a.size() < b.size(); });
+  BOOST_REQUIRE_EQUAL(received[0], small_string);
+  BOOST_REQUIRE(received[1] == large_string);
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().receive_from("chunked", std::chrono::milliseconds(10)),
+                          dunedaq::ipm::ReceiveTimeoutExpired,
+                          [&](dunedaq::ipm::ReceiveTimeoutExpired const&) { return true; });
+
+  // A message of more chunks than the receiver reassembles is refused before any of it goes out
+  std::string too_large_string(testConn.chunk_size * Reassembler::s_max_chunks + 1, 'x');
+  BOOST_REQUIRE_EXCEPTION(
+    NetworkManager::get().send_to(
+      "chunked", too_large_string.c_str(), too_large_string.size(), dunedaq::ipm::Sender::s_block),
+    MessageTooLarge,
+    [&](MessageTooLarge const&) { return true; });
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().receive_from("chunked", std::chrono::milliseconds(10)),
+                          dunedaq::ipm::ReceiveTimeoutExpired,
+                          [&](dunedaq::ipm::ReceiveTimeoutExpired const&) { return true; });
+
+  NetworkManager::get().reset();
+  testConfig[0].envelope = false;
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().configure(testConfig),
+                          EnvelopeRequired,
+                          [&](EnvelopeRequired const&) { return true; });
+}
+
+BOOST_FIXTURE_TEST_CASE(StripingWithChunking, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "striped_chunked";
+  testConn.address = "mem://striped_chunked_0";
+  testConn.stripe_addresses = { "mem://striped_chunked_1", "mem://striped_chunked_2" };
+  testConn.envelope = true;
+  testConn.stripe_ordered = true;
+  testConn.chunk_size = 1000;
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  // The chunks of a message, which share its sequence number, are spread over the stripes; every
+  // message still arrives whole and in the order sent
+  std::vector<std::string> sent;
+  for (int i = 0; i < 20; ++i) {
+    std::string sent_string(i % 2 == 0 ? 3500 + i : 10, static_cast<char>('a' + i));
+    sent_string.replace(0, std::to_string(i).size(), std::to_string(i));
+    sent.push_back(sent_string);
+  }
+  NetworkManager::get().get_receiver("striped_chunked");
+  for (auto& sent_string : sent) {
+    NetworkManager::get().send_to(
+      "striped_chunked", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  }
+  for (auto& sent_string : sent) {
+    auto response = NetworkManager::get().receive_from("striped_chunked", std::chrono::milliseconds(1000));
+    BOOST_REQUIRE(std::string(response.data.begin(), response.data.end()) == sent_string);
+  }
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().receive_from("striped_chunked", std::chrono::milliseconds(50)),
+                          dunedaq::ipm::ReceiveTimeoutExpired,
+                          [&](dunedaq::ipm::ReceiveTimeoutExpired const&) { return true; });
+}
+
+BOOST_FIXTURE_TEST_CASE(WildcardSubscription, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  testConfig.push_back({ "tpsets", "mem://wildcard_tpsets", { "TPSets_a", "TPSets_raw" } });
+  testConfig.push_back({ "hits", "mem://wildcard_hits", { "TPSets_b", "Hits", "Hits_raw" } });
+  testConfig.push_back({ "trigger", "mem://wildcard_trigger", { "Trigger" } });
+  NetworkManager::get().configure(testConfig);
+
+  BOOST_REQUIRE(NetworkManager::get().is_topic("TPSets_*"));
+  BOOST_REQUIRE(!NetworkManager::get().is_topic("Nothing_*"));
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().subscribe("Nothing_*"), TopicNotFound, [&](TopicNotFound const&) {
+    return true;
+  });
+  // Lookups do not register the pattern
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().get_receiver("*_raw"),
+                          ConnectionNotFound,
+                          [&](ConnectionNotFound const&) { return true; });
+  dunedaq::opmonlib::InfoCollector lookup_ci;
+  NetworkManager::get().gather_stats(lookup_ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE(!lookup_ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children].contains("*_raw"));
+  BOOST_REQUIRE(!lookup_ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children].contains("TPSets_*"));
+
+  // "*_raw" subscribes to every topic of both connections, and leaves out those not ending in "_raw" itself
+  NetworkManager::get().get_subscriber("*_raw");
+  std::string sent_string = "this is a test string";
+  for (std::string topic : { "Hits", "Hits_raw" }) {
+    NetworkManager::get().send_to(
+      "hits", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block, topic);
+  }
+  NetworkManager::get().send_to(
+    "tpsets", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block, "TPSets_raw");
+  std::vector<std::string> topics;
+  for (int i = 0; i < 2; ++i) {
+    topics.push_back(NetworkManager::get().receive_from("*_raw", std::chrono::milliseconds(1000)).metadata);
+  }
+  std::sort(topics.begin(), topics.end());
+  BOOST_REQUIRE_EQUAL(topics[0], "Hits_raw");
+  BOOST_REQUIRE_EQUAL(topics[1], "TPSets_raw");
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().receive_from("*_raw", std::chrono::milliseconds(10)),
+                          dunedaq::ipm::ReceiveTimeoutExpired,
+                          [&](dunedaq::ipm::ReceiveTimeoutExpired const&) { return true; });
+
+  // One Listener receives the matching topics of all connections
+  std::mutex received_mutex;
+  std::vector<std::string> received_topics;
+  NetworkManager::get().subscribe("TPSets_*");
+  auto& addresses = NetworkManager::get().get_connection_strings("TPSets_*");
+  BOOST_REQUIRE_EQUAL(addresses.size(), 2);
+  BOOST_REQUIRE_EQUAL(addresses[0], "mem://wildcard_tpsets");
+  BOOST_REQUIRE_EQUAL(addresses[1], "mem://wildcard_hits");
+  NetworkManager::get().register_callback("TPSets_*", [&](dunedaq::ipm::Receiver::Response response) {
+    std::lock_guard<std::mutex> lk(received_mutex);
+    received_topics.push_back(response.metadata);
+  });
+  NetworkManager::get().send_to(
+    "tpsets", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block, "TPSets_a");
+  NetworkManager::get().send_to(
+    "trigger", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block, "Trigger");
+  NetworkManager::get().send_to(
+    "hits", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block, "TPSets_b");
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  size_t received_count = 0;
+  while (received_count < 2 && std::chrono::steady_clock::now() < deadline) {
+    {
+      std::lock_guard<std::mutex> lk(received_mutex);
+      received_count = received_topics.size();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  BOOST_REQUIRE_GE(received_count, 2);
+  NetworkManager::get().unsubscribe("TPSets_*");
+  std::sort(received_topics.begin(), received_topics.end());
+  BOOST_REQUIRE_EQUAL(received_topics.size(), 2);
+  BOOST_REQUIRE_EQUAL(received_topics[0], "TPSets_a");
+  BOOST_REQUIRE_EQUAL(received_topics[1], "TPSets_b");
+
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE(ci.get_collected_infos()[dunedaq::opmonlib::JSONTags::children].contains("TPSets_*"));
+}
+
 BOOST_FIXTURE_TEST_CASE(Publish, NetworkManagerTestFixture)
 {
   std::string sent_string;
@@ -385,6 +1276,105 @@ BOOST_FIXTURE_TEST_CASE(Publish, NetworkManagerTestFixture)
   BOOST_REQUIRE_EQUAL(received_string, "");
 }
 
+BOOST_FIXTURE_TEST_CASE(TopicFanOut, NetworkManagerTestFixture)
+{
+  std::atomic<int> received_count{ 0 };
+  NetworkManager::get().subscribe("baz");
+  NetworkManager::get().register_callback("baz", [&](dunedaq::ipm::Receiver::Response) { ++received_count; });
+
+  // "baz" is declared by both "bar" and "rab"
+  std::string sent_string = "this is a test string";
+  auto failed =
+    NetworkManager::get().publish("baz", sent_string.c_str(), sent_string.size(), dunedaq::ipm::Sender::s_block);
+  BOOST_REQUIRE(failed.empty());
+  for (int i = 0; i < 1000 && received_count < 2; ++i) {
+    usleep(1000);
+  }
+  BOOST_REQUIRE_EQUAL(received_count, 2);
+
+  std::chrono::milliseconds timeout(10);
+  BOOST_REQUIRE_EXCEPTION(
+    NetworkManager::get().publish("unknown_topic", sent_string.c_str(), sent_string.size(), timeout),
+    TopicNotFound,
+    [&](TopicNotFound const&) { return true; });
+  NetworkManager::get().reset();
+
+  // A connection whose sender cannot be created is reported, and does not stop the others
+  nwmgr::Connections testConfig;
+  testConfig.push_back({ "good", "mem://good", { "topic" } });
+  testConfig.push_back({ "bad", "mem://bad?unknown_parameter=1", { "topic" } });
+  NetworkManager::get().configure(testConfig);
+  NetworkManager::get().get_receiver("good");
+
+  failed = NetworkManager::get().publish("topic", sent_string.c_str(), sent_string.size(), timeout);
+  BOOST_REQUIRE_EQUAL(failed.size(), 1);
+  BOOST_REQUIRE_EQUAL(failed[0], "bad");
+  auto response = NetworkManager::get().receive_from("good", std::chrono::milliseconds(1000));
+  BOOST_REQUIRE_EQUAL(std::string(response.data.begin(), response.data.end()), sent_string);
+}
+
+BOOST_FIXTURE_TEST_CASE(RequestReply, NetworkManagerTestFixture)
+{
+  NetworkManager::get().reset();
+
+  nwmgr::Connections testConfig;
+  nwmgr::Connection testConn;
+  testConn.name = "requests";
+  testConn.address = "inproc://requests";
+  testConn.reply_connection = "replies";
+  testConfig.push_back(testConn);
+  testConn.name = "replies";
+  testConn.address = "inproc://replies";
+  testConn.reply_connection = "";
+  testConfig.push_back(testConn);
+  NetworkManager::get().configure(testConfig);
+
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().request("replies", "x", 1, dunedaq::ipm::Sender::s_block),
+                          NoReplyConnection,
+                          [&](NoReplyConnection const&) { return true; });
+  BOOST_REQUIRE_EXCEPTION(NetworkManager::get().register_request_handler(
+                            "requests", [](dunedaq::ipm::Receiver::Response) { return std::vector<char>(); }),
+                          ListenerNotRegistered,
+                          [&](ListenerNotRegistered const&) { return true; });
+
+  // The handler answers each request with its payload reversed, and ignores "ignore me"
+  NetworkManager::get().start_listening("requests");
+  NetworkManager::get().register_request_handler("requests", [](dunedaq::ipm::Receiver::Response request) {
+    if (std::string(request.data.begin(), request.data.end()) == "ignore me") {
+      throw OperationFailed(ERS_HERE, "ignored");
+    }
+    return std::vector<char>(request.data.rbegin(), request.data.rend());
+  });
+
+  // Many requests in flight on the same pair of connections
+  std::vector<std::future<dunedaq::ipm::Receiver::Response>> replies;
+  for (int idx = 0; idx < 100; ++idx) {
+    auto payload = "request " + std::to_string(idx);
+    replies.push_back(
+      NetworkManager::get().request("requests", payload.c_str(), payload.size(), std::chrono::milliseconds(5000)));
+  }
+  for (int idx = 0; idx < 100; ++idx) {
+    auto payload = "request " + std::to_string(idx);
+    auto reply = replies[idx].get();
+    BOOST_REQUIRE_EQUAL(std::string(reply.data.begin(), reply.data.end()),
+                        std::string(payload.rbegin(), payload.rend()));
+  }
+  BOOST_REQUIRE(NetworkManager::get().is_listening("replies"));
+
+  std::string ignored = "ignore me";
+  auto reply =
+    NetworkManager::get().request("requests", ignored.c_str(), ignored.size(), std::chrono::milliseconds(50));
+  BOOST_REQUIRE_EXCEPTION(reply.get(), RequestTimedOut, [&](RequestTimedOut const&) { return true; });
+
+  dunedaq::opmonlib::InfoCollector ci;
+  NetworkManager::get().gather_stats(ci, NetworkManager::s_connection_stats_level);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "requests", "completed", "requests"), 100);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "requests", "timed_out", "requests"), 1);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "requests", "pending", "requests"), 0);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "requests", "sent_messages"), 101);
+  BOOST_REQUIRE_EQUAL(reported_counter(ci, "replies", "sent_messages"), 100);
+}
+
 BOOST_FIXTURE_TEST_CASE(SingleConnectionSubscriber, NetworkManagerTestFixture)
 {
 
@@ -0,0 +1,94 @@
+/**
+ * @file Reconnector_test.cxx Reconnector class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Reconnector.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE Reconnector_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(Reconnector_test)
+
+BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
+{
+  BOOST_REQUIRE(!std::is_copy_constructible_v<Reconnector>);
+  BOOST_REQUIRE(!std::is_copy_assignable_v<Reconnector>);
+  BOOST_REQUIRE(!std::is_move_constructible_v<Reconnector>);
+  BOOST_REQUIRE(!std::is_move_assignable_v<Reconnector>);
+}
+
+BOOST_AUTO_TEST_CASE(Backoff)
+{
+  std::mutex mutex;
+  std::vector<std::chrono::steady_clock::time_point> attempts;
+  Reconnector reconnector([&](std::string const& name) {
+    BOOST_REQUIRE_EQUAL(name, "foo");
+    std::lock_guard<std::mutex> lk(mutex);
+    attempts.push_back(std::chrono::steady_clock::now());
+    return attempts.size() == 4;
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  reconnector.schedule(
+    "foo", std::chrono::milliseconds(0), std::chrono::milliseconds(20), std::chrono::milliseconds(50));
+  BOOST_REQUIRE(reconnector.is_scheduled("foo"));
+
+  // Scheduling again does not add attempts
+  reconnector.schedule(
+    "foo", std::chrono::milliseconds(0), std::chrono::milliseconds(20), std::chrono::milliseconds(50));
+
+  for (int i = 0; i < 1000 && reconnector.is_scheduled("foo"); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  BOOST_REQUIRE(!reconnector.is_scheduled("foo"));
+
+  // Attempts after 0, 20, 20 + 40 and 20 + 40 + 50 ms
+  std::lock_guard<std::mutex> lk(mutex);
+  BOOST_REQUIRE_EQUAL(attempts.size(), 4);
+  BOOST_REQUIRE(attempts[1] - attempts[0] >= std::chrono::milliseconds(20));
+  BOOST_REQUIRE(attempts[2] - attempts[1] >= std::chrono::milliseconds(40));
+  BOOST_REQUIRE(attempts[3] - attempts[2] >= std::chrono::milliseconds(50));
+  BOOST_REQUIRE(attempts[3] - start >= std::chrono::milliseconds(110));
+}
+
+BOOST_AUTO_TEST_CASE(Clear)
+{
+  std::atomic<int> attempts{ 0 };
+  Reconnector reconnector([&](std::string const&) {
+    ++attempts;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return false;
+  });
+
+  reconnector.schedule("foo", std::chrono::milliseconds(0), std::chrono::milliseconds(1), std::chrono::milliseconds(1));
+  reconnector.schedule("bar", std::chrono::hours(1), std::chrono::milliseconds(1), std::chrono::milliseconds(1));
+  while (attempts == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Waits for the attempt in progress, which is then not retried
+  reconnector.clear();
+  BOOST_REQUIRE(!reconnector.is_scheduled("foo"));
+  BOOST_REQUIRE(!reconnector.is_scheduled("bar"));
+  auto attempts_after_clear = attempts.load();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  BOOST_REQUIRE_EQUAL(attempts, attempts_after_clear);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+/**
+ * @file RequestReply_test.cxx RequestHeader and RequestTracker Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/RequestReply.hpp"
+#include "networkmanager/Issues.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE RequestReply_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(RequestReply_test)
+
+BOOST_AUTO_TEST_CASE(HeaderRoundTrip)
+{
+  RequestHeader header;
+  header.kind = RequestHeader::Kind::Reply;
+  header.correlation_id = 0xdeadbeefcafef00d;
+
+  std::vector<char> buffer(RequestHeader::s_size + 3, 'x');
+  header.write(buffer.data());
+
+  RequestHeader read_header;
+  BOOST_REQUIRE(read_header.read(buffer.data(), buffer.size()));
+  BOOST_REQUIRE(read_header.kind == RequestHeader::Kind::Reply);
+  BOOST_REQUIRE_EQUAL(read_header.correlation_id, header.correlation_id);
+  BOOST_REQUIRE_EQUAL(buffer[RequestHeader::s_size], 'x');
+
+  BOOST_REQUIRE(!read_header.read(buffer.data(), RequestHeader::s_size - 1));
+  std::string not_a_request = "this is a plain message without any header";
+  BOOST_REQUIRE(!read_header.read(not_a_request.c_str(), not_a_request.size()));
+}
+
+BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
+{
+  BOOST_REQUIRE(!std::is_copy_constructible_v<RequestTracker>);
+  BOOST_REQUIRE(!std::is_copy_assignable_v<RequestTracker>);
+  BOOST_REQUIRE(!std::is_move_constructible_v<RequestTracker>);
+  BOOST_REQUIRE(!std::is_move_assignable_v<RequestTracker>);
+}
+
+BOOST_AUTO_TEST_CASE(Completion)
+{
+  RequestTracker tracker("test");
+  auto first = tracker.add(std::chrono::milliseconds(10000));
+  auto second = tracker.add(ipm::Receiver::s_block);
+  BOOST_REQUIRE(first.correlation_id != second.correlation_id);
+  BOOST_REQUIRE_EQUAL(tracker.pending(), 2);
+
+  // Replies may arrive in any order
+  ipm::Receiver::Response reply;
+  reply.data = { 'b' };
+  BOOST_REQUIRE(tracker.complete(second.correlation_id, std::move(reply)));
+  reply.data = { 'a' };
+  BOOST_REQUIRE(tracker.complete(first.correlation_id, std::move(reply)));
+  BOOST_REQUIRE_EQUAL(first.reply.get().data[0], 'a');
+  BOOST_REQUIRE_EQUAL(second.reply.get().data[0], 'b');
+
+  // A duplicate reply has no request left to complete
+  BOOST_REQUIRE(!tracker.complete(first.correlation_id, ipm::Receiver::Response()));
+
+  connectioninfo::RequestInfo info;
+  tracker.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.pending, 0);
+  BOOST_REQUIRE_EQUAL(info.completed, 2);
+  BOOST_REQUIRE_EQUAL(info.timed_out, 0);
+  BOOST_REQUIRE_EQUAL(info.late_replies, 1);
+}
+
+BOOST_AUTO_TEST_CASE(CorrelationIds)
+{
+  // Replies meant for another tracker, or an earlier one of the same connection, are not taken for its own
+  RequestTracker tracker("test");
+  RequestTracker other_tracker("test");
+  auto pending = tracker.add(ipm::Receiver::s_block);
+  auto other_pending = other_tracker.add(ipm::Receiver::s_block);
+  BOOST_REQUIRE((pending.correlation_id >> 32) != (other_pending.correlation_id >> 32));
+  BOOST_REQUIRE(!tracker.complete(other_pending.correlation_id, ipm::Receiver::Response()));
+  BOOST_REQUIRE(!other_tracker.complete(pending.correlation_id, ipm::Receiver::Response()));
+  BOOST_REQUIRE_EQUAL(tracker.add(ipm::Receiver::s_block).correlation_id, pending.correlation_id + 1);
+}
+
+BOOST_AUTO_TEST_CASE(Timeout)
+{
+  RequestTracker tracker("test");
+  auto slow = tracker.add(std::chrono::milliseconds(1000));
+  auto fast = tracker.add(std::chrono::milliseconds(10));
+
+  BOOST_REQUIRE(fast.reply.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  BOOST_REQUIRE_EXCEPTION(fast.reply.get(), RequestTimedOut, [&](RequestTimedOut const&) { return true; });
+  BOOST_REQUIRE(slow.reply.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+  BOOST_REQUIRE(!tracker.complete(fast.correlation_id, ipm::Receiver::Response()));
+
+  BOOST_REQUIRE(slow.reply.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  BOOST_REQUIRE_EXCEPTION(slow.reply.get(), RequestTimedOut, [&](RequestTimedOut const&) { return true; });
+
+  connectioninfo::RequestInfo info;
+  tracker.fill_info(info);
+  BOOST_REQUIRE_EQUAL(info.pending, 0);
+  BOOST_REQUIRE_EQUAL(info.timed_out, 2);
+  BOOST_REQUIRE_EQUAL(info.late_replies, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Failure)
+{
+  RequestTracker tracker("test");
+  auto pending = tracker.add(std::chrono::milliseconds(10000));
+  tracker.fail(pending.correlation_id, std::make_exception_ptr(NoReplyConnection(ERS_HERE, "test")));
+  BOOST_REQUIRE_EXCEPTION(pending.reply.get(), NoReplyConnection, [&](NoReplyConnection const&) { return true; });
+  BOOST_REQUIRE_EQUAL(tracker.pending(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Cancellation)
+{
+  std::future<ipm::Receiver::Response> reply;
+  {
+    RequestTracker tracker("test");
+    reply = tracker.add(ipm::Receiver::s_block).reply;
+  }
+  BOOST_REQUIRE_EXCEPTION(reply.get(), RequestCancelled, [&](RequestCancelled const&) { return true; });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
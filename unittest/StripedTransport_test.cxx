@@ -0,0 +1,221 @@
+/**
+ * @file StripedTransport_test.cxx Striped sender and receiver Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/Envelope.hpp"
+#include "networkmanager/Issues.hpp"
+#include "networkmanager/MemoryTransport.hpp"
+#include "networkmanager/StripedTransport.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE StripedTransport_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::networkmanager;
+
+namespace {
+std::shared_ptr<MemoryReceiver>
+open_receiver(std::string const& address)
+{
+  auto receiver = std::make_shared<MemoryReceiver>();
+  receiver->connect_for_receives({ { "connection_string", address } });
+  return receiver;
+}
+
+std::string
+receive_string(ipm::Receiver& receiver)
+{
+  auto response = receiver.receive(std::chrono::milliseconds(1000));
+  return std::string(response.data.begin(), response.data.end());
+}
+
+// A message with an envelope carrying the given sequence number, as NetworkManager sends it
+std::vector<char>
+enveloped(uint64_t sequence_number, std::string const& payload)
+{
+  EnvelopeHeader header;
+  header.sequence_number = sequence_number;
+  header.sender_id = 42;
+  std::vector<char> message(EnvelopeHeader::s_size + payload.size());
+  header.write(message.data());
+  std::copy(payload.begin(), payload.end(), message.begin() + EnvelopeHeader::s_size);
+  return message;
+}
+
+// One chunk of a message, as NetworkManager sends it
+std::vector<char>
+enveloped_chunk(uint64_t sequence_number, uint64_t message_size, uint64_t offset, std::string const& payload)
+{
+  EnvelopeHeader header;
+  header.sequence_number = sequence_number;
+  header.sender_id = 42;
+  header.flags = EnvelopeHeader::s_flag_chunk;
+  ChunkHeader chunk;
+  chunk.message_size = message_size;
+  chunk.offset = offset;
+  std::vector<char> message(EnvelopeHeader::s_size + ChunkHeader::s_size + payload.size());
+  header.write(message.data());
+  chunk.write(message.data() + EnvelopeHeader::s_size);
+  std::copy(payload.begin(), payload.end(), message.begin() + EnvelopeHeader::s_size + ChunkHeader::s_size);
+  return message;
+}
+
+uint64_t
+sequence_number(ipm::Receiver::Response const& response)
+{
+  EnvelopeHeader header;
+  BOOST_REQUIRE(header.read(response.data.data(), response.data.size()));
+  return header.sequence_number;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(StripedTransport_test)
+
+BOOST_AUTO_TEST_CASE(RoundRobin)
+{
+  auto first = open_receiver("mem://round_robin_0");
+  auto second = open_receiver("mem://round_robin_1");
+
+  StripedSender sender({ std::make_shared<MemorySender>(false), std::make_shared<MemorySender>(false) },
+                       nwmgr::StripePolicy::round_robin);
+  BOOST_REQUIRE(!sender.can_send());
+  BOOST_REQUIRE_THROW(sender.connect_for_sends({ { "connection_strings", { "mem://round_robin_0" } } }),
+                      OperationFailed);
+  sender.connect_for_sends({ { "connection_strings", { "mem://round_robin_0", "mem://round_robin_1" } } });
+  BOOST_REQUIRE(sender.can_send());
+  BOOST_REQUIRE_EQUAL(sender.stripe_count(), 2);
+
+  for (std::string message : { "a", "b", "c", "d" }) {
+    sender.send(message.data(), message.size(), ipm::Sender::s_block);
+  }
+  BOOST_REQUIRE_EQUAL(receive_string(*first), "a");
+  BOOST_REQUIRE_EQUAL(receive_string(*second), "b");
+  BOOST_REQUIRE_EQUAL(receive_string(*first), "c");
+  BOOST_REQUIRE_EQUAL(receive_string(*second), "d");
+}
+
+BOOST_AUTO_TEST_CASE(LeastLoaded)
+{
+  auto full = open_receiver("mem://least_loaded_full?capacity=1");
+  auto spare = open_receiver("mem://least_loaded_free");
+
+  StripedSender sender({ std::make_shared<MemorySender>(false), std::make_shared<MemorySender>(false) },
+                       nwmgr::StripePolicy::least_loaded);
+  sender.connect_for_sends(
+    { { "connection_strings", { "mem://least_loaded_full?capacity=1", "mem://least_loaded_free" } } });
+
+  // Once the first stripe is full, every message goes to the second, without waiting
+  std::string message = "message";
+  for (int i = 0; i < 4; ++i) {
+    sender.send(message.data(), message.size(), std::chrono::milliseconds(1000));
+  }
+  BOOST_REQUIRE_EQUAL(receive_string(*full), message);
+  for (int i = 0; i < 3; ++i) {
+    BOOST_REQUIRE_EQUAL(receive_string(*spare), message);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MergedReceive)
+{
+  MemorySender first(false);
+  MemorySender second(false);
+  first.connect_for_sends({ { "connection_string", "mem://merged_0" } });
+  second.connect_for_sends({ { "connection_string", "mem://merged_1" } });
+
+  StripedReceiver receiver({ std::make_shared<MemoryReceiver>(), std::make_shared<MemoryReceiver>() }, false);
+  BOOST_REQUIRE(!receiver.can_receive());
+  receiver.connect_for_receives({ { "connection_strings", { "mem://merged_0", "mem://merged_1" } } });
+  BOOST_REQUIRE(receiver.can_receive());
+
+  BOOST_REQUIRE_THROW(receiver.receive(std::chrono::milliseconds(10)), ipm::ReceiveTimeoutExpired);
+
+  // A busy stripe does not hold up the others
+  std::string message = "first";
+  for (int i = 0; i < 3; ++i) {
+    first.send(message.data(), message.size(), ipm::Sender::s_block);
+  }
+  message = "second";
+  second.send(message.data(), message.size(), ipm::Sender::s_block);
+  std::vector<std::string> received;
+  for (int i = 0; i < 4; ++i) {
+    received.push_back(receive_string(receiver));
+  }
+  BOOST_REQUIRE(received[0] == "second" || received[1] == "second");
+  BOOST_REQUIRE_EQUAL(std::count(received.begin(), received.end(), "first"), 3);
+}
+
+BOOST_AUTO_TEST_CASE(OrderedReceive)
+{
+  MemorySender first(false);
+  MemorySender second(false);
+  first.connect_for_sends({ { "connection_string", "mem://ordered_0" } });
+  second.connect_for_sends({ { "connection_string", "mem://ordered_1" } });
+
+  StripedReceiver receiver({ std::make_shared<MemoryReceiver>(), std::make_shared<MemoryReceiver>() }, true);
+  receiver.connect_for_receives({ { "connection_strings", { "mem://ordered_0", "mem://ordered_1" } } });
+
+  // Message 1 overtakes message 0 on the other stripe
+  for (uint64_t sequence_number : { 1, 3 }) {
+    auto message = enveloped(sequence_number, "payload");
+    first.send(message.data(), message.size(), ipm::Sender::s_block);
+  }
+  auto message = enveloped(0, "payload");
+  second.send(message.data(), message.size(), ipm::Sender::s_block);
+
+  BOOST_REQUIRE_EQUAL(sequence_number(receiver.receive(std::chrono::milliseconds(1000))), 0);
+  BOOST_REQUIRE_EQUAL(sequence_number(receiver.receive(std::chrono::milliseconds(1000))), 1);
+
+  // Message 2 never arrives, so message 3 is delivered once it has waited for the reorder window
+  auto start = std::chrono::steady_clock::now();
+  BOOST_REQUIRE_EQUAL(sequence_number(receiver.receive(std::chrono::milliseconds(1000))), 3);
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+
+  // Late messages, and messages without an envelope, are passed on straight away
+  message = enveloped(2, "payload");
+  second.send(message.data(), message.size(), ipm::Sender::s_block);
+  BOOST_REQUIRE_EQUAL(sequence_number(receiver.receive(std::chrono::milliseconds(1000))), 2);
+  std::string plain = "plain";
+  second.send(plain.data(), plain.size(), ipm::Sender::s_block);
+  BOOST_REQUIRE_EQUAL(receive_string(receiver), plain);
+}
+
+BOOST_AUTO_TEST_CASE(OrderedChunks)
+{
+  MemorySender first(false);
+  MemorySender second(false);
+  first.connect_for_sends({ { "connection_string", "mem://ordered_chunks_0" } });
+  second.connect_for_sends({ { "connection_string", "mem://ordered_chunks_1" } });
+
+  StripedReceiver receiver({ std::make_shared<MemoryReceiver>(), std::make_shared<MemoryReceiver>() }, true);
+  receiver.connect_for_receives(
+    { { "connection_strings", { "mem://ordered_chunks_0", "mem://ordered_chunks_1" } } });
+
+  // Both chunks of message 1 are held until the last chunk of message 0 has been passed on
+  for (auto message : { enveloped_chunk(0, 8, 0, "aaaa"), enveloped_chunk(1, 8, 0, "bbbb"), enveloped(2, "payload") }) {
+    first.send(message.data(), message.size(), ipm::Sender::s_block);
+  }
+  for (auto message : { enveloped_chunk(1, 8, 4, "cccc"), enveloped_chunk(0, 8, 4, "dddd") }) {
+    second.send(message.data(), message.size(), ipm::Sender::s_block);
+  }
+
+  std::vector<uint64_t> received;
+  for (int i = 0; i < 5; ++i) {
+    received.push_back(sequence_number(receiver.receive(std::chrono::milliseconds(1000))));
+  }
+  BOOST_REQUIRE(received == std::vector<uint64_t>({ 0, 0, 1, 1, 2 }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
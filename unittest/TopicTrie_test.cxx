@@ -0,0 +1,79 @@
+/**
+ * @file TopicTrie_test.cxx TopicPattern and TopicTrie Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/TopicTrie.hpp"
+
+#define BOOST_TEST_MODULE TopicTrie_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(TopicTrie_test)
+
+BOOST_AUTO_TEST_CASE(PatternMatching)
+{
+  BOOST_REQUIRE(TopicPattern::is_pattern("TPSets_*"));
+  BOOST_REQUIRE(!TopicPattern::is_pattern("TPSets_1"));
+
+  TopicPattern prefix("TPSets_*");
+  BOOST_REQUIRE_EQUAL(prefix.prefix(), "TPSets_");
+  BOOST_REQUIRE(prefix.matches("TPSets_"));
+  BOOST_REQUIRE(prefix.matches("TPSets_APA1"));
+  BOOST_REQUIRE(!prefix.matches("TPSet"));
+  BOOST_REQUIRE(!prefix.matches("Hits_APA1"));
+
+  TopicPattern infix("TPSets_*_raw");
+  BOOST_REQUIRE(infix.matches("TPSets_APA1_raw"));
+  BOOST_REQUIRE(infix.matches("TPSets__raw"));
+  BOOST_REQUIRE(infix.matches("TPSets_raw_raw"));
+  BOOST_REQUIRE(!infix.matches("TPSets_raw"));
+  BOOST_REQUIRE(!infix.matches("TPSets_APA1_raw_copy"));
+
+  TopicPattern several("*_APA*_*");
+  BOOST_REQUIRE_EQUAL(several.prefix(), "");
+  BOOST_REQUIRE(several.matches("TPSets_APA1_raw"));
+  BOOST_REQUIRE(several.matches("_APA_"));
+  BOOST_REQUIRE(!several.matches("TPSets_APA1"));
+
+  TopicPattern exact("TPSets_1");
+  BOOST_REQUIRE(exact.matches("TPSets_1"));
+  BOOST_REQUIRE(!exact.matches("TPSets_10"));
+}
+
+BOOST_AUTO_TEST_CASE(TrieMatch)
+{
+  TopicTrie trie;
+  for (std::string topic : { "TPSets_APA2", "TPSets_APA1", "TPSets", "Hits_APA1", "TPSets_APA1" }) {
+    trie.insert(topic);
+  }
+  BOOST_REQUIRE_EQUAL(trie.size(), 4);
+
+  auto matches = trie.match(TopicPattern("TPSets_*"));
+  BOOST_REQUIRE_EQUAL(matches.size(), 2);
+  BOOST_REQUIRE_EQUAL(matches[0], "TPSets_APA1");
+  BOOST_REQUIRE_EQUAL(matches[1], "TPSets_APA2");
+
+  matches = trie.match(TopicPattern("*APA1"));
+  BOOST_REQUIRE_EQUAL(matches.size(), 2);
+  BOOST_REQUIRE_EQUAL(matches[0], "Hits_APA1");
+  BOOST_REQUIRE_EQUAL(matches[1], "TPSets_APA1");
+
+  BOOST_REQUIRE_EQUAL(trie.match(TopicPattern("TPSets")).size(), 1);
+  BOOST_REQUIRE(trie.match(TopicPattern("Trigger*")).empty());
+  BOOST_REQUIRE_EQUAL(trie.match(TopicPattern("*")).size(), 4);
+
+  trie.clear();
+  BOOST_REQUIRE_EQUAL(trie.size(), 0);
+  BOOST_REQUIRE(trie.match(TopicPattern("*")).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+/**
+ * @file WorkerPool_test.cxx WorkerPool class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "networkmanager/WorkerPool.hpp"
+
+#define BOOST_TEST_MODULE WorkerPool_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace dunedaq::networkmanager;
+
+BOOST_AUTO_TEST_SUITE(WorkerPool_test)
+
+BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
+{
+  BOOST_REQUIRE(!std::is_copy_constructible_v<WorkerPool>);
+  BOOST_REQUIRE(!std::is_copy_assignable_v<WorkerPool>);
+  BOOST_REQUIRE(!std::is_move_constructible_v<WorkerPool>);
+  BOOST_REQUIRE(!std::is_move_assignable_v<WorkerPool>);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelTasks)
+{
+  WorkerPool pool(4);
+  BOOST_REQUIRE_EQUAL(pool.thread_count(), 0);
+
+  // Blocking tasks run at the same time, up to the number of threads
+  std::atomic<int> done{ 0 };
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 4; ++i) {
+    pool.submit([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      ++done;
+    });
+  }
+  while (done < 4) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200));
+  BOOST_REQUIRE_EQUAL(pool.thread_count(), 4);
+
+  // Idle threads are reused rather than more started
+  done = 0;
+  for (int i = 0; i < 8; ++i) {
+    pool.submit([&] { ++done; });
+  }
+  while (done < 8) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  BOOST_REQUIRE_EQUAL(pool.thread_count(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(QueuedTasksRunBeforeDestruction)
+{
+  std::atomic<int> done{ 0 };
+  {
+    WorkerPool pool(1);
+    for (int i = 0; i < 10; ++i) {
+      pool.submit([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++done;
+      });
+    }
+  }
+  BOOST_REQUIRE_EQUAL(done, 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()